@@ -0,0 +1,64 @@
+#pragma once
+// Timing, argument and table helpers shared by the micro-benchmarks
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace BenchUtil {
+
+    // Command-line options: [size] [repetitions], with per-benchmark defaults
+    struct Arguments {
+        size_t size;
+        int repetitions;
+    };
+
+    inline Arguments parseArguments(const int argc, char** argv, const size_t defaultSize, const int defaultRepetitions) {
+        return { argc > 1 ? std::strtoull(argv[1], nullptr, 10) : defaultSize,
+                 argc > 2 ? std::max(1, std::atoi(argv[2])) : defaultRepetitions };
+    }
+
+    // Best rate over `repetitions` timed runs of `run`, in `units` per second (pass bytes / 1e9
+    // for GB/s, say). One untimed run first warms the caches and pages in the buffers.
+    inline double bestThroughput(const std::function<void()>& run, const double units, const int repetitions) {
+        run();
+
+        double best = 0.0;
+        for (int i = 0; i < repetitions; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::max(best, units / seconds);
+        }
+        return best;
+    }
+
+    // Result tables: a left-aligned label column followed by right-aligned value columns
+    constexpr int ColumnWidth = 10;
+
+    inline void printHeader(const std::string& label, const int labelWidth, const std::vector<std::string>& columns,
+                            const std::string& unit) {
+        std::cout << std::left << std::setw(labelWidth) << label;
+        for (const auto& column : columns) {
+            std::cout << std::right << std::setw(ColumnWidth) << column;
+        }
+        std::cout << "   (" << unit << ")\n";
+    }
+
+    inline void printLabel(const std::string& label, const int labelWidth, const int precision) {
+        std::cout << std::left << std::setw(labelWidth) << label << std::fixed << std::setprecision(precision);
+    }
+
+    inline void printValue(const double value) {
+        std::cout << std::right << std::setw(ColumnWidth) << value;
+    }
+
+    // For an instruction set the CPU does not support
+    inline void printMissing() {
+        std::cout << std::right << std::setw(ColumnWidth) << "-";
+    }
+}
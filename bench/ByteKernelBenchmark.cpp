@@ -0,0 +1,61 @@
+// Measures throughput of the byte-wise cipher kernels for every instruction set the
+// CPU supports. Usage: hidenseek-bench-kernels [buffer MiB] [repetitions]
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "util/simd/ByteKernels.h"
+
+using ByteKernels::Isa;
+
+int main(int argc, char** argv) {
+    const auto [mebibytes, repetitions] = BenchUtil::parseArguments(argc, argv, 256, 5);
+    const size_t bytes = mebibytes * 1024 * 1024;
+
+    std::vector<unsigned char> buffer(bytes);
+    for (size_t i = 0; i < bytes; ++i) buffer[i] = static_cast<unsigned char>(i * 131);
+
+    const std::string password = "benchmark-password";
+    const ByteKernels::RepeatingKey key(std::span(reinterpret_cast<const unsigned char*>(password.data()), password.size()));
+
+    const std::vector<std::pair<std::string, std::function<void()>>> kernels = {
+        { "xor",    [&] { ByteKernels::xorRepeatingKey(buffer, key, 0); } },
+        { "rotn",   [&] { ByteKernels::rotateLeft(buffer, 3); } },
+        { "addbit", [&] { ByteKernels::addConstant(buffer, 1); } },
+        { "bitnot", [&] { ByteKernels::bitwiseNot(buffer); } },
+    };
+
+    const std::vector<Isa> isas = { Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512 };
+    std::vector<std::string> columns;
+    for (const Isa isa : isas) columns.push_back(ByteKernels::isaName(isa));
+
+    std::cout << "Buffer: " << mebibytes << " MiB, best of " << repetitions << " runs, detected "
+              << ByteKernels::isaName(ByteKernels::detectIsa()) << "\n\n";
+    BenchUtil::printHeader("kernel", 10, columns, "GB/s");
+
+    for (const auto& [name, kernel] : kernels) {
+        BenchUtil::printLabel(name, 10, 2);
+        for (const Isa isa : isas) {
+            ByteKernels::setIsa(isa);
+            if (ByteKernels::activeIsa() != isa) {
+                BenchUtil::printMissing();
+                continue;
+            }
+            BenchUtil::printValue(BenchUtil::bestThroughput(kernel, bytes / 1e9, repetitions));
+        }
+        std::cout << "\n";
+    }
+
+    // Reference point: copying half the buffer reads and writes each byte once, like the kernels do
+    BenchUtil::printLabel("memcpy", 10, 2);
+    BenchUtil::printValue(BenchUtil::bestThroughput([&] {
+        std::copy(buffer.begin(), buffer.begin() + bytes / 2, buffer.begin() + bytes / 2);
+    }, bytes / 2 / 1e9, repetitions));
+    std::cout << "\n";
+
+    ByteKernels::setIsa(ByteKernels::detectIsa());
+    return 0;
+}
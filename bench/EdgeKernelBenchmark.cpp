@@ -0,0 +1,68 @@
+// Measures PVD edge-map throughput (megapixels per second) for the luma and gradient kernels
+// on every instruction set the CPU supports. Usage: hidenseek-bench-edges [megapixels] [repetitions]
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "util/simd/EdgeKernels.h"
+
+using EdgeKernels::Isa;
+
+int main(int argc, char** argv) {
+    const auto [megapixels, repetitions] = BenchUtil::parseArguments(argc, argv, 12, 5);
+    constexpr size_t width = 4000;
+    const size_t height = std::max<size_t>(3, megapixels * 1000 * 1000 / width);
+    const size_t pixels = width * height;
+
+    std::vector<unsigned char> rgb(pixels * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<unsigned char>(i * 131 + (i >> 7));
+    std::vector<unsigned char> luma(pixels);
+    std::vector<unsigned char> edges(pixels);
+    std::vector<unsigned char> reference;
+
+    const std::vector<Isa> isas = { Isa::Scalar, Isa::AVX2 };
+    std::vector<std::string> columns;
+    for (const Isa isa : isas) columns.push_back(EdgeKernels::isaName(isa));
+
+    std::cout << "Carrier: " << width << "x" << height << " RGB, best of " << repetitions << " runs, detected "
+              << EdgeKernels::isaName(EdgeKernels::detectIsa()) << "\n\n";
+    BenchUtil::printHeader("kernel", 12, columns, "megapixels/s");
+
+    for (const bool gradient : { false, true }) {
+        BenchUtil::printLabel(gradient ? "edgeRow" : "luma", 12, 1);
+        for (const Isa isa : isas) {
+            EdgeKernels::setIsa(isa);
+            if (EdgeKernels::activeIsa() != isa) {
+                BenchUtil::printMissing();
+                continue;
+            }
+            const auto kernel = gradient
+                ? std::function<void()>([&] {
+                      for (size_t y = 1; y + 1 < height; ++y) {
+                          EdgeKernels::edgeRow(std::span(luma).subspan((y - 1) * width, width),
+                                               std::span(luma).subspan(y * width, width),
+                                               std::span(luma).subspan((y + 1) * width, width),
+                                               101 * 101, std::span(edges).subspan(y * width, width));
+                      }
+                  })
+                : std::function<void()>([&] { EdgeKernels::luma(rgb, 3, luma); });
+            BenchUtil::printValue(BenchUtil::bestThroughput(kernel, pixels / 1e6, repetitions));
+
+            if (gradient) {
+                if (reference.empty()) {
+                    reference = edges;
+                } else if (edges != reference) {
+                    std::cerr << "\nedge map mismatch on " << EdgeKernels::isaName(isa) << "\n";
+                    return 1;
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+
+    EdgeKernels::setIsa(EdgeKernels::detectIsa());
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Measures LSB embed/extract throughput (payload bytes per second) at every bit depth for
+// every instruction set the CPU supports. Usage: hidenseek-bench-lsb [payload MiB] [repetitions]
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "util/simd/LSBKernels.h"
+
+using LSBKernels::Isa;
+
+int main(int argc, char** argv) {
+    const auto [mebibytes, repetitions] = BenchUtil::parseArguments(argc, argv, 16, 5);
+    const size_t bytes = mebibytes * 1024 * 1024;
+
+    std::vector<unsigned char> payload(bytes);
+    for (size_t i = 0; i < bytes; ++i) payload[i] = static_cast<unsigned char>(i * 131);
+    std::vector<unsigned char> extracted(bytes);
+    std::vector<unsigned char> carrier(bytes * LSBKernels::carrierBytesPerByte(1));
+    for (size_t i = 0; i < carrier.size(); ++i) carrier[i] = static_cast<unsigned char>(i * 17);
+
+    const std::vector<Isa> isas = { Isa::Scalar, Isa::BMI2, Isa::AVX2 };
+    std::vector<std::string> columns;
+    for (const Isa isa : isas) columns.push_back(LSBKernels::isaName(isa));
+
+    std::cout << "Payload: " << mebibytes << " MiB, best of " << repetitions << " runs, detected "
+              << LSBKernels::isaName(LSBKernels::detectIsa()) << "\n\n";
+    BenchUtil::printHeader("kernel", 12, columns, "GB/s of payload");
+
+    for (int bits = 1; bits <= 4; ++bits) {
+        for (const bool embed : { true, false }) {
+            BenchUtil::printLabel((embed ? "embed:" : "extract:") + std::to_string(bits), 12, 2);
+            for (const Isa isa : isas) {
+                LSBKernels::setIsa(isa);
+                if (LSBKernels::activeIsa() != isa) {
+                    BenchUtil::printMissing();
+                    continue;
+                }
+                const auto kernel = embed
+                    ? std::function<void()>([&] { LSBKernels::embed(carrier, payload, bits); })
+                    : std::function<void()>([&] { LSBKernels::extract(carrier, extracted, bits); });
+                BenchUtil::printValue(BenchUtil::bestThroughput(kernel, bytes / 1e9, repetitions));
+
+                if (!embed && !std::equal(payload.begin(), payload.end(), extracted.begin())) {
+                    std::cerr << "\nround trip mismatch at " << bits << " bits\n";
+                    return 1;
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+
+    LSBKernels::setIsa(LSBKernels::detectIsa());
+    return 0;
+}
@@ -1,26 +1,40 @@
 #include "ImageCryptoApp.h"
 #include <cxxopts.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <fstream>
-#include <QDebug>
+#include <filesystem>
+#include <optional>
 
+#include "batch/BatchManifest.h"
 #include "crypt/impl/addbit/AddBitImageEncryptor.h"
 #include "crypt/impl/aes256/AES256ImageEncryptor.h"
 #include "crypt/impl/bitnot/BitwiseNotImageEncryptor.h"
+#include "crypt/impl/blowfish/BlowfishImageEncryptor.h"
 #include "crypt/impl/channelswap/SwapChannelsImageEncryptor.h"
 #include "crypt/impl/pixelpermutation/PixelPermutationEncryptor.h"
 #include "crypt/impl/rotn/RotNImageEncryptor.h"
 #include "crypt/impl/xor/XORAlgorithm.h"
+#include "img/HnsContainer.h"
 #include "img/ImageLoader.h"
 #include "img/ImageUtils.h"
-#include "steno/impl/lsb/LSBSteganography.h"
+#include "img/PngStream.h"
+#include "img/ProgressiveImage.h"
+#include "steno/SteganographyRegistry.h"
+#include "steno/StegoPayload.h"
+#include "util/kdf/KeyDerivation.h"
+#include "util/thread/ThreadPool.h"
 
 void ImageCryptoApp::log(const std::string& message) const {
+    // Batch items and the image loader log from pool threads
+    const std::lock_guard lock(logMutex);
     if (logFunction) {
         logFunction(message);
     } else {
-        qDebug() << message.c_str();
+        std::cerr << message << std::endl;
     }
 }
 
@@ -28,15 +42,23 @@ ImageCryptoApp::ImageCryptoApp()
     : options("HideNSeek", "Image encryption and steganography tool") {
 
     options.add_options()
+        ("h,help", "Show this help")
         ("d,debug", "Enable debug output")
         ("dec,decrypt", "Decrypt mode (default: encrypt)")
+        ("threads", "Worker threads (0 = one per core)", cxxopts::value<int>()->default_value("0"))
+        ("kdf", "Key derivation for new outputs (pbkdf2|scrypt|argon2id)", cxxopts::value<std::string>()->default_value("pbkdf2"))
+        ("kdf-cost", "Key derivation cost (low|standard|high)", cxxopts::value<std::string>()->default_value("standard"))
+        ("png-level", "PNG compression for outputs (store|fast|default|best)", cxxopts::value<std::string>()->default_value("default"))
+        ("png-filter", "PNG row filter (adaptive|none|sub|up|average|paeth)", cxxopts::value<std::string>()->default_value("adaptive"))
         ("fi,inputFile", "Input image file", cxxopts::value<std::string>())
         ("fo,outputFile", "Output image file", cxxopts::value<std::string>())
         ("step,steps", "Encryption steps (e.g. aes256:1)", cxxopts::value<std::vector<std::string>>())
+        ("batch", "Encrypt or decrypt every item of a .jsonl/.csv manifest, a directory or a pattern like in/*.png", cxxopts::value<std::string>())
+        ("report", "Per-item result report for --batch (JSON lines)", cxxopts::value<std::string>())
         ("mpw,masterPassword", "Master password", cxxopts::value<std::string>()->default_value(""))
         // Steganography options
         ("steg", "Steganography mode (hide|extract)", cxxopts::value<std::string>())
-        ("algo", "Steganography algorithm (lsb|pvd)", cxxopts::value<std::string>())
+        ("algo", "Steganography algorithm (lsb[:bits]|pvd[:edge threshold]|auto)", cxxopts::value<std::string>())
         ("data", "Data to hide or extract to", cxxopts::value<std::string>())
         ("pass", "Steganography password", cxxopts::value<std::string>()->default_value(""))
         ("image", "Treat data as image", cxxopts::value<bool>());
@@ -46,14 +68,47 @@ void ImageCryptoApp::run(const int argc, char** argv) {
     try {
         result = options.parse(argc, argv);
 
+        if (result.count("help")) {
+            log(options.help());
+            return;
+        }
+
         debug = result["debug"].as<bool>();
         if (debug) {
             log("ImageCryptoApp starting.");
             log("Debug mode is enabled.");
         }
 
+        // Load and save messages are debug output like the rest
+        if (debug) {
+            ImageLoader::setLogFunction([this](const std::string& message) { log(message); });
+        } else {
+            ImageLoader::setLogFunction(nullptr);
+        }
+
+        ThreadPool::instance().setThreadCount(std::max(0, result["threads"].as<int>()));
+        if (debug) {
+            log("Using " + std::to_string(ThreadPool::instance().threadCount()) + " worker threads.");
+        }
+
+        // Only affects new outputs; decryption reads the parameters stored with the data
+        KeyDerivation::setDefaultParams(KeyDerivation::preset(
+            KeyDerivation::parseAlgorithm(result["kdf"].as<std::string>()),
+            result["kdf-cost"].as<std::string>()));
+        if (debug) {
+            log("Key derivation: " + KeyDerivation::describe(KeyDerivation::defaultParams()));
+        }
+
+        pngEncoding.level = PngEncoding::parseLevel(result["png-level"].as<std::string>());
+        pngEncoding.filter = PngEncoding::parseFilter(result["png-filter"].as<std::string>());
+
         registerAlgorithms();
 
+        if (result.count("batch")) {
+            processBatch();
+            return;
+        }
+
         if (result.count("steg")) {
             processSteganographyMode();
             return;
@@ -68,16 +123,21 @@ void ImageCryptoApp::run(const int argc, char** argv) {
 }
 
 void ImageCryptoApp::registerAlgorithms() {
-    algorithms["addbit"] = std::make_shared<AddBitImageEncryptor>();
-    algorithms["xor"] = std::make_shared<XORImageEncryptor>();
-    algorithms["rotn"] = std::make_shared<RotNImageEncryptor>();
-    algorithms["bitnot"] = std::make_shared<BitwiseNotImageEncryptor>();
-    algorithms["channelswap"] = std::make_shared<SwapChannelsImageEncryptor>();
-    algorithms["pixelperm"] = std::make_shared<PixelPermutationEncryptor>();
-    algorithms["aes256"] = std::make_shared<AES256ImageEncryptor>();
-
-    stegAlgorithms["lsb"] = std::make_shared<LSBSteganography>(3);
-    stegAlgorithms["pvd"] = std::make_shared<LSBSteganography>(4);
+    // Algorithms hold no per-run state, so they are built once and shared with batch workers
+    if (algorithms) return;
+
+    auto crypto = std::make_shared<AlgorithmMap>();
+    (*crypto)["addbit"] = std::make_shared<AddBitImageEncryptor>();
+    (*crypto)["xor"] = std::make_shared<XORImageEncryptor>();
+    (*crypto)["rotn"] = std::make_shared<RotNImageEncryptor>();
+    (*crypto)["bitnot"] = std::make_shared<BitwiseNotImageEncryptor>();
+    (*crypto)["channelswap"] = std::make_shared<SwapChannelsImageEncryptor>();
+    (*crypto)["pixelperm"] = std::make_shared<PixelPermutationEncryptor>();
+    (*crypto)["aes256"] = std::make_shared<AES256ImageEncryptor>();
+    (*crypto)["blowfish"] = std::make_shared<BlowfishImageEncryptor>();
+    algorithms = std::move(crypto);
+
+    stegRegistry = std::make_shared<const SteganographyRegistry>(SteganographyRegistry::withBuiltins());
 }
 
 void ImageCryptoApp::processSteganographyMode() {
@@ -99,8 +159,12 @@ void ImageCryptoApp::processSteganographyMode() {
         hiddenData = result["data"].as<std::string>();
     }
 
-    workImage = ImageLoader::loadImage(inputPath);
-    if (debug) ImageUtils::printImageInfo(workImage, "Input Image");
+    // Extraction decodes the carrier only as far as it has to, see extractSteganographyData()
+    if (stegMode == "hide") {
+        // Carriers are embedded as RGB: PVD needs colour, and gray would hold a third as much
+        workImage = ImageUtils::convertTo3Channels(ImageLoader::loadImage(inputPath));
+        if (debug) ImageUtils::printImageInfo(workImage, "Input Image");
+    }
 
     processSteganography();
 }
@@ -123,104 +187,178 @@ void ImageCryptoApp::processEncryptionMode() {
         stepsToRun = result["steps"].as<std::vector<std::string>>();
     }
 
+    processEncryption();
+}
+
+void ImageCryptoApp::processEncryption() {
+    if (streamImageEncryption()) {
+        return;
+    }
+
     workImage = ImageLoader::loadImage(inputPath);
     if (debug) ImageUtils::printImageInfo(workImage, "Debug Image Info");
 
     processImageEncryption();
 }
 
-void ImageCryptoApp::processImageEncryption() {
-    Image currentImage = workImage;
-
-    if (decrypt && stepsToRun.empty()) {
-        recoverEncryptionSteps(currentImage);
+void ImageCryptoApp::processBatch() {
+    if (result.count("steg")) {
+        throw std::runtime_error("Batch mode covers encryption and decryption only");
     }
 
-    if (stepsToRun.empty()) {
-        throw std::runtime_error("No encryption steps specified");
+    const std::string source = result["batch"].as<std::string>();
+    std::vector<BatchItem> items = BatchManifest::load(source);
+    if (items.empty()) {
+        throw std::runtime_error("Batch has no items: " + source);
     }
 
-    std::vector<std::string> steps = stepsToRun;
-    if (decrypt) {
-        std::ranges::reverse(steps);
+    // Command-line options are the defaults for whatever an item leaves out. For items
+    // without an output, --outputFile names the directory to write them to.
+    const bool defaultDecrypt = result["decrypt"].as<bool>();
+    const std::string defaultPassword = result["masterPassword"].as<std::string>();
+    const std::vector<std::string> defaultSteps = result.count("steps")
+        ? result["steps"].as<std::vector<std::string>>() : std::vector<std::string>();
+    const std::filesystem::path outputDir = result.count("outputFile") ? result["outputFile"].as<std::string>() : "";
+
+    for (auto& item : items) {
+        if (item.output.empty()) {
+            item.output = outputDir.empty() ? std::filesystem::path(item.input.string() + ".processed")
+                                            : outputDir / item.input.filename();
+        }
     }
-
-    for (const auto& stepStr : steps) {
-        currentImage = applyEncryptionStep(currentImage, stepStr, decrypt);
+    if (!outputDir.empty()) {
+        std::filesystem::create_directories(outputDir);
     }
 
-    outImage = currentImage;
+    const std::filesystem::path reportPath = result.count("report") ? std::filesystem::path(result["report"].as<std::string>())
+        : std::filesystem::is_regular_file(source) ? std::filesystem::path(source + ".report.jsonl")
+        : (outputDir.empty() ? std::filesystem::path(".") : outputDir) / "batch-report.jsonl";
 
-    if (!decrypt) {
-        embedEncryptionMetadata();
+    if (debug) {
+        log("Batch of " + std::to_string(items.size()) + " items from " + source);
     }
 
-    ImageLoader::saveImage(outputPath, outImage, false);
+    // Items run side by side on the shared pool, each with its own state. Keys derived for
+    // one item are reused by the others through the process-wide key cache.
+    std::vector<BatchResult> results(items.size());
+    ThreadPool::instance().parallelFor(items.size(), 1, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                ImageCryptoApp worker;
+                worker.setLogFunction([this](const std::string& message) { log(message); });
+                worker.debug = debug;
+                worker.pngEncoding = pngEncoding;
+                worker.algorithms = algorithms;
+                worker.stegRegistry = stegRegistry;
+
+                worker.decrypt = items[i].decrypt.value_or(defaultDecrypt);
+                worker.masterPassword = BatchManifest::resolvePassword(items[i].passwordRef, defaultPassword);
+                if (worker.masterPassword.empty()) {
+                    throw std::runtime_error("Master password is required");
+                }
+                worker.stepsToRun = items[i].steps.value_or(defaultSteps);
+                worker.inputPath = items[i].input.string();
+                worker.outputPath = items[i].output.string();
+
+                worker.processEncryption();
+                results[i].ok = true;
+            } catch (const std::exception& e) {
+                results[i].error = e.what();
+            }
+            results[i].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    });
 
-    if (debug) {
-        log("Process completed. Output saved to: " + outputPath);
+    BatchManifest::writeReport(reportPath, items, results);
+
+    const auto failed = std::ranges::count_if(results, [](const BatchResult& r) { return !r.ok; });
+    log("Batch finished: " + std::to_string(items.size() - failed) + " of " + std::to_string(items.size()) +
+        " items succeeded. Report: " + reportPath.string());
+    if (failed > 0) {
+        throw std::runtime_error(std::to_string(failed) + " batch items failed, see " + reportPath.string());
     }
 }
 
-Image ImageCryptoApp::applyEncryptionStep(const Image& input, const std::string& stepStr, bool isDecrypt) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(stepStr);
-    std::string token;
+std::vector<std::string> ImageCryptoApp::pipelineSteps(const Image& image) {
+    if (decrypt && stepsToRun.empty()) {
+        recoverEncryptionSteps(image);
+    }
 
-    while (std::getline(iss, token, ':')) {
-        tokens.push_back(token);
+    if (stepsToRun.empty()) {
+        throw std::runtime_error("No encryption steps specified");
     }
 
-    if (tokens.empty()) {
-        throw std::runtime_error("Invalid step format: " + stepStr);
+    std::vector<std::string> steps = stepsToRun;
+    if (decrypt) {
+        std::ranges::reverse(steps);
     }
+    return steps;
+}
 
-    std::string algoName = tokens[0];
-    int count = 1;
-    std::string param;
+EncryptionPipeline ImageCryptoApp::makePipeline() {
+    EncryptionPipeline pipeline([this](const std::string& name) { return getAlgorithm(name); }, masterPassword);
+    if (debug) {
+        pipeline.setLogFunction([this](const std::string& message) { log(message); });
+    }
+    return pipeline;
+}
 
-    if (tokens.size() >= 2) {
-        try {
-            count = std::stoi(tokens[1]);
-        } catch (...) {
-            count = 1;
-            param = tokens[1];
-        }
+bool ImageCryptoApp::streamImageEncryption() {
+    // Reading and writing the same file row by row would overwrite rows before they are read
+    if (!PngReader::supports(inputPath) || HnsContainer::hasExtension(outputPath) ||
+        std::filesystem::weakly_canonical(inputPath) == std::filesystem::weakly_canonical(outputPath)) {
+        return false;
     }
 
-    if (tokens.size() >= 3) {
-        param = tokens[2];
+    // Only the sidecar metadata is needed up front, to recover the steps when decrypting
+    Image metadataImage;
+    ImageLoader::loadMetadata(inputPath, metadataImage);
+
+    const std::vector<std::string> steps = pipelineSteps(metadataImage);
+    const EncryptionPipeline pipeline = makePipeline();
+    PngReader reader(inputPath);
+    if (!pipeline.canStream(steps, reader.channels(), decrypt)) {
+        return false;
     }
 
-    auto algorithm = getAlgorithm(algoName);
-    if (!algorithm) {
-        throw std::runtime_error("Unknown algorithm: " + algoName);
+    if (debug) {
+        log("Streaming " + std::to_string(reader.width()) + "x" + std::to_string(reader.height()) +
+            " image through the pipeline");
     }
 
-    Image current = input;
+    PngWriter writer(outputPath, reader.width(), reader.height(), reader.channels(), pngEncoding);
+    pipeline.runStreaming(reader.width(), reader.height(), reader.channels(), steps, decrypt,
+                          [&](const std::span<unsigned char> row) { return reader.readRow(row); },
+                          [&](const std::span<const unsigned char> row) { writer.writeRow(row); });
+    writer.finish();
 
-    for (int i = 0; i < count; ++i) {
-        Image next;
-        std::string key = param.empty() ? masterPassword : param;
+    outImage = Image();
+    if (!decrypt) {
+        embedEncryptionMetadata();
+    }
+    ImageLoader::saveMetadata(outputPath, outImage);
 
-        if (debug) {
-            log("Step: " + algoName + " (" + std::to_string(i + 1) + "/" + std::to_string(count) + ")");
-        }
+    if (debug) {
+        log("Process completed. Output saved to: " + outputPath);
+    }
+    return true;
+}
 
-        if (isDecrypt) {
-            algorithm->decrypt(current, next, key);
-        } else {
-            algorithm->encrypt(current, next, key);
-        }
+void ImageCryptoApp::processImageEncryption() {
+    const std::vector<std::string> steps = pipelineSteps(workImage);
 
-        if (next.width != current.width || next.height != current.height || next.channels != current.channels) {
-            throw std::runtime_error("Algorithm " + algoName + " corrupted image dimensions");
-        }
+    outImage = makePipeline().run(workImage, steps, decrypt);
 
-        current = std::move(next);
+    if (!decrypt) {
+        embedEncryptionMetadata();
     }
 
-    return current;
+    ImageLoader::saveImage(outputPath, outImage, false, pngEncoding);
+
+    if (debug) {
+        log("Process completed. Output saved to: " + outputPath);
+    }
 }
 
 void ImageCryptoApp::recoverEncryptionSteps(const Image& image) {
@@ -303,87 +441,109 @@ void ImageCryptoApp::processSteganography() {
 }
 
 void ImageCryptoApp::hideSteganographyData() {
-    auto steg = getSteganographyAlgorithm(stegAlgo);
-    if (!steg) {
-        throw std::runtime_error("Steganography algorithm not found: " + stegAlgo);
+    const std::vector<std::string> candidates = steganographyCandidates();
+
+    std::string dataToHide;
+    if (hideAsImage) {
+        hideImage = ImageLoader::loadImage(hiddenData);
+        if (debug) ImageUtils::printImageInfo(hideImage, "Data Image to Hide");
+    } else if (std::ifstream file(hiddenData); file.good()) {
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        dataToHide = buffer.str();
+        if (debug) {
+            log("Loaded data from file: " + hiddenData + " (" + std::to_string(dataToHide.size()) + " bytes)");
+        }
+    } else {
+        dataToHide = hiddenData;
+        if (debug) {
+            log("Using literal string data (" + std::to_string(dataToHide.size()) + " bytes)");
+        }
     }
 
-    if (debug) {
-        log("Hiding data using " + stegAlgo + " algorithm...");
+    // The image is sealed once and every candidate plans and embeds from the same bytes,
+    // instead of compressing and deriving the key again for the check and for the embed
+    std::optional<StegoPayload::Prepared> prepared;
+    if (hideAsImage) {
+        prepared.emplace(ImageUtils::serializeImage(hideImage), stegPassword);
     }
 
     bool success = false;
 
-    if (hideAsImage) {
-        hideImage = ImageLoader::loadImage(hiddenData);
-        if (debug) ImageUtils::printImageInfo(hideImage, "Data Image to Hide");
+    // Embeds straight into the loaded carrier; a candidate the payload does not fit leaves it untouched
+    for (const auto& spec : candidates) {
+        const auto steg = getSteganographyAlgorithm(spec);
 
-        const auto res = steg->canEmbedData(workImage, hideImage, stegPassword);
+        if (debug) {
+            log("Hiding data using " + spec + " algorithm...");
+        }
 
-        log("Can hide image: " + std::to_string(std::get<0>(res)));
-        log("Data size: " + std::to_string(std::get<1>(res)));
-        log("Carrier Image capacity: " + std::to_string(std::get<2>(res)));
+        if (hideAsImage) {
+            const auto res = steg->canEmbedData(workImage, *prepared);
 
-        if (!std::get<0>(res)) {
-            throw std::runtime_error("Image too small to hide the specified data");
-        }
+            log("Can hide image: " + std::to_string(std::get<0>(res)));
+            log("Data size: " + std::to_string(std::get<1>(res)));
+            log("Carrier Image capacity: " + std::to_string(std::get<2>(res)));
 
-        success = steg->hideImage(workImage, hideImage, outImage, stegPassword);
-    } else {
-        std::string dataToHide;
+            if (!std::get<0>(res)) continue;
 
-        if (std::ifstream file(hiddenData); file.good()) {
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            dataToHide = buffer.str();
-            if (debug) {
-                log("Loaded data from file: " + hiddenData + " (" + std::to_string(dataToHide.size()) + " bytes)");
-            }
+            success = steg->hidePayload(workImage, *prepared, workImage);
         } else {
-            dataToHide = hiddenData;
-            if (debug) {
-                log("Using literal string data (" + std::to_string(dataToHide.size()) + " bytes)");
-            }
+            success = steg->hideData(workImage, dataToHide, workImage, stegPassword);
         }
 
-        success = steg->hideData(workImage, dataToHide, outImage, stegPassword);
+        if (success) {
+            if (candidates.size() > 1) {
+                log("Selected steganography algorithm: " + spec);
+            }
+            break;
+        }
     }
 
     if (!success) {
-        throw std::runtime_error("Steganography failed: Could not hide data");
+        throw std::runtime_error(hideAsImage ? "Image too small to hide the specified data"
+                                             : "Steganography failed: Could not hide data");
     }
 
-    ImageLoader::saveImage(outputPath, outImage, false);
+    ImageLoader::saveImage(outputPath, workImage, false, pngEncoding);
     if (debug) {
         log("Steganographic image saved to: " + outputPath);
     }
 }
 
 void ImageCryptoApp::extractSteganographyData() {
-    const auto steg = getSteganographyAlgorithm(stegAlgo);
-    if (!steg) {
-        throw std::runtime_error("Steganography algorithm not found: " + stegAlgo);
-    }
+    bool success = false;
+    std::string extracted;
+    ProgressiveImage carrier(inputPath);
 
-    if (debug) {
-        log("Extracting data using " + stegAlgo + " algorithm...");
-    }
+    // With "auto" every candidate is tried; the first whose payload decrypts and inflates wins
+    for (const auto& spec : steganographyCandidates()) {
+        const auto steg = getSteganographyAlgorithm(spec);
 
-    bool success = false;
+        if (debug) {
+            log("Extracting data using " + spec + " algorithm...");
+        }
+
+        const Image& image = decodeForExtraction(carrier, *steg);
+        if (debug) {
+            log("Decoded " + std::to_string(image.height) + " carrier rows");
+        }
+
+        success = hideAsImage ? steg->extractImage(image, outImage, stegPassword) && !outImage.pixels.empty()
+                              : steg->extractData(image, extracted, stegPassword);
+        if (success) break;
+    }
 
     if (hideAsImage) {
-        success = steg->extractImage(workImage, outImage, stegPassword);
-        if (!success || outImage.pixels.empty()) {
+        if (!success) {
             throw std::runtime_error("No hidden image could be extracted");
         }
 
-        ImageLoader::saveImage(outputPath, outImage, false);
+        ImageLoader::saveImage(outputPath, outImage, false, pngEncoding);
         if (debug) {
             log("Extracted image saved to: " + outputPath);
         }
     } else {
-        std::string extracted;
-        success = steg->extractData(workImage, extracted, stegPassword);
         if (!success) {
             throw std::runtime_error("No hidden data could be extracted");
         }
@@ -404,12 +564,28 @@ void ImageCryptoApp::extractSteganographyData() {
     }
 }
 
+const Image& ImageCryptoApp::decodeForExtraction(ProgressiveImage& carrier, const SteganographyAlgorithm& steg) {
+    // Each pass may reveal more of the payload's extent (a size header, say), so repeat until it is covered
+    while (!carrier.complete()) {
+        const size_t extent = steg.extractionExtent(carrier.image().pixelView());
+        if (extent != 0 && extent <= carrier.image().pixels.size()) break;
+        carrier.require(extent);
+    }
+    return carrier.image();
+}
+
 std::shared_ptr<CryptoAlgorithm> ImageCryptoApp::getAlgorithm(const std::string& name) {
-    const auto it = algorithms.find(name);
-    return (it != algorithms.end()) ? it->second : nullptr;
+    const auto it = algorithms->find(name);
+    return (it != algorithms->end()) ? it->second : nullptr;
 }
 
-std::shared_ptr<SteganographyAlgorithm> ImageCryptoApp::getSteganographyAlgorithm(const std::string& name) {
-    const auto it = stegAlgorithms.find(name);
-    return (it != stegAlgorithms.end()) ? it->second : nullptr;
+std::shared_ptr<SteganographyAlgorithm> ImageCryptoApp::getSteganographyAlgorithm(const std::string& spec) {
+    return stegRegistry->create(spec);
+}
+
+std::vector<std::string> ImageCryptoApp::steganographyCandidates() const {
+    if (stegAlgo == SteganographyRegistry::AutoSpec) {
+        return stegRegistry->getAutoCandidates();
+    }
+    return { stegAlgo };
 }
\ No newline at end of file
@@ -5,12 +5,17 @@
 #include <map>
 #include <memory>
 #include <functional>
+#include <mutex>
 
 #include "crypt/CryptoAlgorithm.h"
+#include "crypt/EncryptionPipeline.h"
 #include "img/Image.h"
+#include "img/PngStream.h"
+#include "img/ProgressiveImage.h"
 #include <cxxopts.hpp>
 
 #include "steno/SteganographyAlgorithm.h"
+#include "steno/SteganographyRegistry.h"
 
 class ImageCryptoApp {
 public:
@@ -20,11 +25,14 @@ public:
     void setLogFunction(LogFunction logFunc) { logFunction = logFunc; }
 
     void run(int argc, char** argv);
-    void registerAlgorithms();
+    void registerAlgorithms();                  // Once per app; later calls keep the existing registries
 
     // Main processing methods
     void processEncryptionMode();               // New encryption processing
+    void processEncryption();                   // Encrypts or decrypts inputPath into outputPath
+    void processBatch();                        // Every item of a manifest or directory, in one process
     void processImageEncryption();              // Core encryption logic
+    bool streamImageEncryption();               // Row-streamed variant for large PNGs
 
     // Steganography methods
     void processSteganography();
@@ -37,12 +45,15 @@ public:
 private:
     // Algorithm getters
     std::shared_ptr<CryptoAlgorithm> getAlgorithm(const std::string& name);
-    std::shared_ptr<SteganographyAlgorithm> getSteganographyAlgorithm(const std::string& name);
+    std::shared_ptr<SteganographyAlgorithm> getSteganographyAlgorithm(const std::string& spec);
+    [[nodiscard]] std::vector<std::string> steganographyCandidates() const;
+    static const Image& decodeForExtraction(ProgressiveImage& carrier, const SteganographyAlgorithm& steg);
 
     // New encryption helper methods
-    Image applyEncryptionStep(const Image& input, const std::string& stepStr, bool isDecrypt);
     void recoverEncryptionSteps(const Image& image);
     void embedEncryptionMetadata();
+    [[nodiscard]] std::vector<std::string> pipelineSteps(const Image& image);
+    [[nodiscard]] EncryptionPipeline makePipeline();
 
     // Command line parsing
     cxxopts::Options options;
@@ -62,6 +73,9 @@ private:
     bool debug = false;
     bool decrypt = false;
 
+    // Output settings
+    PngEncoding pngEncoding;
+
     // Encryption settings
     std::vector<std::string> stepsToRun;
     std::string masterPassword;
@@ -73,12 +87,14 @@ private:
     std::string hiddenData;
     bool hideAsImage = false;
 
-    // Algorithm registries
-    std::map<std::string, std::shared_ptr<CryptoAlgorithm>> algorithms;
-    std::map<std::string, std::shared_ptr<SteganographyAlgorithm>> stegAlgorithms;
+    // Algorithm registries, shared with batch workers
+    using AlgorithmMap = std::map<std::string, std::shared_ptr<CryptoAlgorithm>>;
+    std::shared_ptr<const AlgorithmMap> algorithms;
+    std::shared_ptr<const SteganographyRegistry> stegRegistry;
 
     // Logging
     LogFunction logFunction;
+    mutable std::mutex logMutex;
 
     void log(const std::string& message) const;
 };
\ No newline at end of file
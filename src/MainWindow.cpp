@@ -162,7 +162,7 @@ void MainWindow::setupSteganographyTab() {
 
     optionsLayout->addWidget(new QLabel("Algorithm:"), 0, 0);
     algorithmCombo = new QComboBox;
-    algorithmCombo->addItems({"LSB", "PVD"});
+    algorithmCombo->addItems({"LSB", "PVD", "Auto"});
     optionsLayout->addWidget(algorithmCombo, 0, 1);
 
     optionsLayout->addWidget(new QLabel("Password:"), 1, 0);
@@ -265,7 +265,7 @@ void MainWindow::addEncryptionStep() const {
     stepsTable->insertRow(row);
 
     auto *algoCombo = new QComboBox;
-    algoCombo->addItems({"addbit", "xor", "rotn", "bitnot", "channelswap", "pixelperm", "aes256"});
+    algoCombo->addItems({"addbit", "xor", "rotn", "bitnot", "channelswap", "pixelperm", "aes256", "blowfish"});
     stepsTable->setCellWidget(row, 0, algoCombo);
 
     auto *paramEdit = new QLineEdit;
@@ -0,0 +1,391 @@
+#include "BatchManifest.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace BatchManifest {
+
+namespace {
+    // Field values as read: a string, or a list of strings for JSON arrays
+    struct Value {
+        std::string text;
+        std::optional<std::vector<std::string>> list;
+    };
+    using Fields = std::map<std::string, Value>;
+
+    std::vector<std::string> splitWords(const std::string& text) {
+        std::istringstream stream(text);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word) {
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    // Just enough JSON for one flat object per line: string keys mapping to strings,
+    // arrays of strings, numbers, booleans or null
+    class JsonLine {
+    public:
+        explicit JsonLine(const std::string& line) : text(line) {}
+
+        Fields parseObject() {
+            Fields fields;
+            expect('{');
+            if (peek() == '}') {
+                ++at;
+            } else {
+                do {
+                    const std::string key = parseString();
+                    expect(':');
+                    fields[key] = parseValue();
+                } while (consume(','));
+                expect('}');
+            }
+            if (peek() != '\0') fail("trailing characters");
+            return fields;
+        }
+
+    private:
+        [[noreturn]] static void fail(const std::string& what) {
+            throw std::runtime_error("invalid JSON: " + what);
+        }
+
+        char peek() {
+            while (at < text.size() && std::isspace(static_cast<unsigned char>(text[at]))) ++at;
+            return at < text.size() ? text[at] : '\0';
+        }
+
+        bool consume(const char c) {
+            if (peek() != c) return false;
+            ++at;
+            return true;
+        }
+
+        void expect(const char c) {
+            if (!consume(c)) fail(std::string("expected '") + c + "'");
+        }
+
+        Value parseValue() {
+            Value value;
+            if (peek() == '"') {
+                value.text = parseString();
+            } else if (consume('[')) {
+                value.list.emplace();
+                if (!consume(']')) {
+                    do {
+                        value.list->push_back(parseString());
+                    } while (consume(','));
+                    expect(']');
+                }
+            } else {
+                // Numbers, booleans and null are kept as their literal text
+                const size_t start = at;
+                while (at < text.size() && (std::isalnum(static_cast<unsigned char>(text[at])) ||
+                                            text[at] == '-' || text[at] == '+' || text[at] == '.')) {
+                    ++at;
+                }
+                if (at == start) fail("unexpected character");
+                value.text = text.substr(start, at - start);
+            }
+            return value;
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string out;
+            while (at < text.size() && text[at] != '"') {
+                char c = text[at++];
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (at >= text.size()) break;
+                switch (c = text[at++]) {
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': appendCodePoint(out, parseHex4()); break;
+                    default:  out += c; break;
+                }
+            }
+            expect('"');
+            return out;
+        }
+
+        unsigned parseHex4() {
+            if (at + 4 > text.size()) fail("short \\u escape");
+            unsigned code = 0;
+            for (int i = 0; i < 4; ++i) {
+                const char c = text[at++];
+                code <<= 4;
+                if (c >= '0' && c <= '9') code |= c - '0';
+                else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+                else fail("bad \\u escape");
+            }
+            // A high surrogate pairs with the low one that follows
+            if (code >= 0xD800 && code < 0xDC00 && text.compare(at, 2, "\\u") == 0) {
+                at += 2;
+                const unsigned low = parseHex4();
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            return code;
+        }
+
+        static void appendCodePoint(std::string& out, const unsigned code) {
+            if (code < 0x80) {
+                out += static_cast<char>(code);
+            } else if (code < 0x800) {
+                out += static_cast<char>(0xC0 | code >> 6);
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                out += static_cast<char>(0xE0 | code >> 12);
+                out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | code >> 18);
+                out += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+                out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        const std::string& text;
+        size_t at = 0;
+    };
+
+    // RFC 4180 fields: comma-separated, optionally double-quoted with "" for a quote
+    std::vector<std::string> splitCsv(const std::string& line) {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            const char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    fields.back() += '"';
+                    ++i;
+                } else if (c == '"') {
+                    quoted = false;
+                } else {
+                    fields.back() += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.emplace_back();
+            } else if (c != '\r') {
+                fields.back() += c;
+            }
+        }
+        if (quoted) throw std::runtime_error("unterminated quote");
+        return fields;
+    }
+
+    BatchItem toItem(const Fields& fields, const std::filesystem::path& base) {
+        auto text = [&](const std::string& key) {
+            const auto it = fields.find(key);
+            return it == fields.end() ? std::string() : it->second.text;
+        };
+        auto resolve = [&](const std::string& path) {
+            const std::filesystem::path p(path);
+            return p.is_relative() ? base / p : p;
+        };
+
+        BatchItem item;
+        if (text("input").empty()) throw std::runtime_error("missing input");
+        item.input = resolve(text("input"));
+        if (const std::string output = text("output"); !output.empty()) {
+            item.output = resolve(output);
+        }
+
+        if (const auto it = fields.find("steps"); it != fields.end()) {
+            item.steps = it->second.list ? *it->second.list : splitWords(it->second.text);
+            if (item.steps->empty()) item.steps.reset();
+        }
+
+        item.passwordRef = fields.contains("password_ref") ? text("password_ref") : text("password-ref");
+        // Password files are found the same way as the images
+        if (item.passwordRef.starts_with("file:")) {
+            item.passwordRef = "file:" + resolve(item.passwordRef.substr(5)).string();
+        }
+
+        if (const std::string mode = text("mode"); mode == "decrypt") {
+            item.decrypt = true;
+        } else if (mode == "encrypt") {
+            item.decrypt = false;
+        } else if (!mode.empty()) {
+            throw std::runtime_error("unknown mode '" + mode + "' (use encrypt or decrypt)");
+        }
+        return item;
+    }
+
+    std::vector<BatchItem> loadManifest(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open batch manifest: " + path.string());
+        }
+
+        std::string extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+        const bool csv = extension == ".csv";
+        if (!csv && extension != ".jsonl" && extension != ".json") {
+            throw std::runtime_error("Batch manifest must be .jsonl or .csv: " + path.string());
+        }
+
+        const std::filesystem::path base = path.parent_path();
+        std::vector<BatchItem> items;
+        std::vector<std::string> header;
+        std::string line;
+        for (size_t number = 1; std::getline(file, line); ++number) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            try {
+                Fields fields;
+                if (!csv) {
+                    fields = JsonLine(line).parseObject();
+                } else if (header.empty()) {
+                    header = splitCsv(line);
+                    for (auto& name : header) {
+                        const std::vector<std::string> words = splitWords(name);
+                        name = words.empty() ? "" : words.front();
+                    }
+                    continue;
+                } else {
+                    const std::vector<std::string> values = splitCsv(line);
+                    if (values.size() > header.size()) throw std::runtime_error("more fields than the header");
+                    for (size_t i = 0; i < values.size(); ++i) {
+                        fields[header[i]].text = values[i];
+                    }
+                }
+                items.push_back(toItem(fields, base));
+            } catch (const std::exception& e) {
+                throw std::runtime_error(path.string() + ":" + std::to_string(number) + ": " + e.what());
+            }
+        }
+        return items;
+    }
+
+    bool matches(const std::string& pattern, const std::string& name) {
+        // Iterative wildcard match with backtracking to the last '*'
+        size_t p = 0, n = 0, star = std::string::npos, mark = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                ++p;
+                ++n;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                mark = n;
+            } else if (star != std::string::npos) {
+                p = star + 1;
+                n = ++mark;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') ++p;
+        return p == pattern.size();
+    }
+
+    std::vector<BatchItem> listFiles(const std::filesystem::path& directory, const std::string& pattern) {
+        if (!std::filesystem::is_directory(directory)) {
+            throw std::runtime_error("Batch directory does not exist: " + directory.string());
+        }
+
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.is_regular_file() && matches(pattern, entry.path().filename().string())) {
+                paths.push_back(entry.path());
+            }
+        }
+        // Directory order is unspecified; sort so reports are stable
+        std::ranges::sort(paths);
+
+        std::vector<BatchItem> items(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            items[i].input = paths[i];
+        }
+        return items;
+    }
+
+    std::string jsonString(const std::string& text) {
+        std::ostringstream out;
+        out << '"';
+        for (const char c : text) {
+            switch (c) {
+                case '"':  out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\r': out << "\\r"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+}
+
+std::vector<BatchItem> load(const std::string& source) {
+    const std::filesystem::path path(source);
+    if (std::filesystem::is_directory(path)) {
+        return listFiles(path, "*");
+    }
+    if (const std::string name = path.filename().string(); name.find_first_of("*?") != std::string::npos) {
+        return listFiles(path.parent_path().empty() ? "." : path.parent_path(), name);
+    }
+    return loadManifest(path);
+}
+
+std::string resolvePassword(const std::string& ref, const std::string& fallback) {
+    if (ref.empty()) {
+        return fallback;
+    }
+    if (ref.starts_with("env:")) {
+        const char* value = std::getenv(ref.substr(4).c_str());
+        if (!value) {
+            throw std::runtime_error("Password variable is not set: " + ref.substr(4));
+        }
+        return value;
+    }
+    if (ref.starts_with("file:")) {
+        std::ifstream file(ref.substr(5));
+        std::string password;
+        if (!file || !std::getline(file, password)) {
+            throw std::runtime_error("Cannot read password file: " + ref.substr(5));
+        }
+        if (!password.empty() && password.back() == '\r') password.pop_back();
+        return password;
+    }
+    throw std::runtime_error("Unknown password reference (use env:NAME or file:PATH)");
+}
+
+void writeReport(const std::filesystem::path& path, const std::vector<BatchItem>& items,
+                 const std::vector<BatchResult>& results) {
+    std::ofstream report(path);
+    if (!report) {
+        throw std::runtime_error("Cannot write batch report: " + path.string());
+    }
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        report << "{\"input\":" << jsonString(items[i].input.string())
+               << ",\"output\":" << jsonString(items[i].output.string())
+               << ",\"status\":" << (results[i].ok ? "\"ok\"" : "\"error\"");
+        if (!results[i].ok) {
+            report << ",\"error\":" << jsonString(results[i].error);
+        }
+        report << ",\"seconds\":" << std::fixed << std::setprecision(3) << results[i].seconds << "}\n";
+    }
+}
+}
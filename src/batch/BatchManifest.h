@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// One image for batch mode to encrypt or decrypt. Fields left unset fall back to the
+// command-line options.
+struct BatchItem {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    std::optional<std::vector<std::string>> steps;
+    std::string passwordRef;
+    std::optional<bool> decrypt;
+};
+
+// Outcome of one batch item, in manifest order
+struct BatchResult {
+    bool ok = false;
+    std::string error;
+    double seconds = 0.0;
+};
+
+// Lists the work for batch mode and reports on it afterwards. Manifests hold one item per
+// JSON line or CSV row, with the fields input, output, steps, password_ref and mode
+// (encrypt|decrypt); only input is required.
+namespace BatchManifest {
+    // Reads a .jsonl or .csv manifest, or lists a directory or a file-name pattern such as
+    // "in/*.png" ('*' and '?' match within the name only). Relative manifest paths, password
+    // files included, are taken from the manifest's directory. Throws on malformed manifests, naming the line.
+    [[nodiscard]] std::vector<BatchItem> load(const std::string& source);
+
+    // "env:NAME" reads an environment variable and "file:PATH" the first line of a file, so
+    // manifests never hold passwords themselves. An empty reference gives `fallback`.
+    [[nodiscard]] std::string resolvePassword(const std::string& ref, const std::string& fallback);
+
+    // One JSON line per item: input, output, status ("ok" or "error"), error and seconds
+    void writeReport(const std::filesystem::path& path, const std::vector<BatchItem>& items,
+                     const std::vector<BatchResult>& results);
+}
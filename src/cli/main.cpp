@@ -0,0 +1,16 @@
+#include <iostream>
+#include "../ImageCryptoApp.h"
+
+// Command-line front end: the same engine and options as the GUI, without loading Qt
+int main(int argc, char *argv[]) {
+    ImageCryptoApp app;
+    app.setLogFunction([](const std::string& message) { std::cout << message << std::endl; });
+
+    try {
+        app.run(argc, argv);
+    } catch (const std::exception&) {
+        // run() has already logged the error
+        return 1;
+    }
+    return 0;
+}
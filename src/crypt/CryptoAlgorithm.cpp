@@ -0,0 +1,11 @@
+#include "CryptoAlgorithm.h"
+
+#include "TileExecutor.h"
+
+void CryptoAlgorithm::transform(const std::span<unsigned char> pixels, const int channels, const std::string& key, const bool decrypt) {
+    const PixelKernel kernel = makeKernel(key, channels, decrypt);
+    if (!kernel) {
+        throw std::logic_error("Algorithm " + name() + " cannot run in place");
+    }
+    TileExecutor::run(pixels, channels, kernel);
+}
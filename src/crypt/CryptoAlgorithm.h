@@ -1,13 +1,51 @@
 #pragma once
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "../img/Image.h"
 
+// Transforms a run of pixel bytes in place. `offset` is the index of block[0]
+// within the whole pixel buffer; blocks always start on a pixel boundary.
+using PixelKernel = std::function<void(std::span<unsigned char> block, size_t offset)>;
+
 class CryptoAlgorithm {
 public:
     virtual ~CryptoAlgorithm() = default;
-    virtual void encrypt(const Image& input, Image& output, const std::string& key) = 0;
-    virtual void decrypt(const Image& input, Image& output, const std::string& key) = 0;
+
+    // Default implementations copy into `output` (reusing its buffer) and run transform() on it.
+    virtual void encrypt(const Image& input, Image& output, const std::string& key) {
+        copyPixels(input, output);
+        transform(output.pixels, output.channels, key, false);
+    }
+    virtual void decrypt(const Image& input, Image& output, const std::string& key) {
+        copyPixels(input, output);
+        transform(output.pixels, output.channels, key, true);
+    }
+
     [[nodiscard]] virtual std::string name() const = 0;
     [[nodiscard]] virtual std::vector<std::string> getEncryptionSteps(const Image& in) const = 0;
+
+    // Whether transform() may be called; algorithms that need a separate output buffer return false.
+    [[nodiscard]] virtual bool supportsInPlace() const { return false; }
+
+    // Encrypts or decrypts a whole image's pixel buffer in place. The default runs
+    // makeKernel() over the buffer through TileExecutor.
+    virtual void transform(std::span<unsigned char> pixels, int channels, const std::string& key, bool decrypt);
+
+    // Pixel-local algorithms return a kernel so consecutive steps can be fused into
+    // a single pass over the image. An empty kernel means the step must be materialised.
+    [[nodiscard]] virtual PixelKernel makeKernel(const std::string& key, int channels, bool decrypt) const {
+        return {};
+    }
+
+protected:
+    static void copyPixels(const Image& input, Image& output) {
+        if (&input == &output) return;
+        output.reshape(input.width, input.height, input.channels);
+        std::ranges::copy(input.pixels, output.pixels.begin());
+    }
 };
@@ -0,0 +1,186 @@
+#include "EncryptionPipeline.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "TileExecutor.h"
+
+EncryptionPipeline::EncryptionPipeline(AlgorithmLookup lookup, std::string defaultKey)
+    : lookup(std::move(lookup)), defaultKey(std::move(defaultKey)) {}
+
+void EncryptionPipeline::log(const std::string& message) const {
+    if (logFunction) {
+        logFunction(message);
+    }
+}
+
+EncryptionPipeline::Step EncryptionPipeline::parseStep(const std::string& stepStr) {
+    std::vector<std::string> tokens;
+    std::istringstream iss(stepStr);
+    std::string token;
+
+    while (std::getline(iss, token, ':')) {
+        tokens.push_back(token);
+    }
+
+    if (tokens.empty()) {
+        throw std::runtime_error("Invalid step format: " + stepStr);
+    }
+
+    Step step;
+    step.algoName = tokens[0];
+
+    if (tokens.size() >= 2) {
+        try {
+            step.count = std::stoi(tokens[1]);
+        } catch (...) {
+            step.count = 1;
+            step.param = tokens[1];
+        }
+    }
+
+    if (tokens.size() >= 3) {
+        step.param = tokens[2];
+    }
+
+    return step;
+}
+
+std::vector<EncryptionPipeline::Stage> EncryptionPipeline::compile(const std::vector<std::string>& steps,
+                                                                   const int channels,
+                                                                   const bool decrypt) const {
+    std::vector<Stage> stages;
+
+    for (const auto& stepStr : steps) {
+        const Step step = parseStep(stepStr);
+
+        auto algorithm = lookup(step.algoName);
+        if (!algorithm) {
+            throw std::runtime_error("Unknown algorithm: " + step.algoName);
+        }
+        if (step.count <= 0) continue;
+
+        const std::string key = step.param.empty() ? defaultKey : step.param;
+        const std::string label = step.algoName + " x" + std::to_string(step.count);
+
+        if (PixelKernel kernel = algorithm->makeKernel(key, channels, decrypt)) {
+            if (stages.empty() || stages.back().kernels.empty()) {
+                stages.push_back(Stage{ .description = "Fused pass:" });
+            }
+            Stage& fused = stages.back();
+            for (int i = 0; i < step.count; ++i) {
+                fused.kernels.push_back(kernel);
+            }
+            fused.description += " " + label;
+        } else {
+            stages.push_back(Stage{
+                .description = "Step: " + label,
+                .algorithm = std::move(algorithm),
+                .algoName = step.algoName,
+                .key = key,
+                .count = step.count
+            });
+        }
+    }
+
+    return stages;
+}
+
+Image EncryptionPipeline::run(const Image& input, const std::vector<std::string>& steps, const bool decrypt) const {
+    const auto stages = compile(steps, input.channels, decrypt);
+    if (stages.empty()) {
+        return input;
+    }
+
+    // Two buffers serve the whole chain: `front` holds the current image and `back`
+    // receives the output of steps that cannot run in place, after which they swap.
+    Image front;
+    Image back;
+    const Image* source = &input;
+
+    for (const auto& stage : stages) {
+        log(stage.description);
+
+        if (!stage.kernels.empty()) {
+            front.reshape(source->width, source->height, source->channels);
+            TileExecutor::run(source->pixels.data(), front.pixels, front.channels, stage.kernels);
+        } else if (stage.algorithm->supportsInPlace()) {
+            if (source != &front) {
+                front.reshape(source->width, source->height, source->channels);
+                std::ranges::copy(source->pixels, front.pixels.begin());
+            }
+            for (int i = 0; i < stage.count; ++i) {
+                stage.algorithm->transform(front.pixels, front.channels, stage.key, decrypt);
+            }
+        } else {
+            runMaterialised(stage, *source, front, back, decrypt);
+        }
+        source = &front;
+    }
+
+    return front;
+}
+
+bool EncryptionPipeline::canStream(const std::vector<std::string>& steps, const int channels,
+                                   const bool decrypt) const {
+    return std::ranges::all_of(compile(steps, channels, decrypt),
+                               [](const Stage& stage) { return !stage.kernels.empty(); });
+}
+
+void EncryptionPipeline::runStreaming(const int width, const int height, const int channels,
+                                      const std::vector<std::string>& steps, const bool decrypt,
+                                      const RowSource& source, const RowSink& sink) const {
+    const auto stages = compile(steps, channels, decrypt);
+    if (!std::ranges::all_of(stages, [](const Stage& stage) { return !stage.kernels.empty(); })) {
+        throw std::runtime_error("Pipeline contains steps that need the whole image");
+    }
+
+    // Every stage is a chain of kernels, so they are concatenated into one pass per band
+    std::vector<PixelKernel> kernels;
+    for (const auto& stage : stages) {
+        log(stage.description);
+        kernels.insert(kernels.end(), stage.kernels.begin(), stage.kernels.end());
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    const int bandRows = static_cast<int>(std::clamp<size_t>(StreamBandBytes / std::max<size_t>(rowBytes, 1), 1, std::max(height, 1)));
+    std::vector<unsigned char> band(bandRows * rowBytes);
+
+    for (int y = 0; y < height; y += bandRows) {
+        const int rows = std::min(bandRows, height - y);
+        const std::span<unsigned char> pixels(band.data(), rows * rowBytes);
+
+        for (int r = 0; r < rows; ++r) {
+            if (!source(pixels.subspan(r * rowBytes, rowBytes))) {
+                throw std::runtime_error("Image ended after " + std::to_string(y + r) + " of " +
+                                         std::to_string(height) + " rows");
+            }
+        }
+
+        TileExecutor::run(pixels.data(), pixels, channels, kernels, static_cast<size_t>(y) * rowBytes);
+
+        for (int r = 0; r < rows; ++r) {
+            sink(pixels.subspan(r * rowBytes, rowBytes));
+        }
+    }
+}
+
+void EncryptionPipeline::runMaterialised(const Stage& stage, const Image& source, Image& front, Image& back,
+                                         const bool decrypt) const {
+    const Image* input = &source;
+
+    for (int i = 0; i < stage.count; ++i) {
+        if (decrypt) {
+            stage.algorithm->decrypt(*input, back, stage.key);
+        } else {
+            stage.algorithm->encrypt(*input, back, stage.key);
+        }
+
+        if (back.width != input->width || back.height != input->height || back.channels != input->channels) {
+            throw std::runtime_error("Algorithm " + stage.algoName + " corrupted image dimensions");
+        }
+
+        std::swap(front, back);
+        input = &front;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "CryptoAlgorithm.h"
+#include "../img/Image.h"
+
+// Compiles a list of step strings ("algo[:count][:param]") into stages and runs them.
+// Consecutive pixel-local steps are fused into one kernel pass over the pixel buffer,
+// in-place algorithms transform that buffer directly, and anything else is applied
+// through CryptoAlgorithm::encrypt/decrypt into a second, reused buffer.
+class EncryptionPipeline {
+public:
+    using AlgorithmLookup = std::function<std::shared_ptr<CryptoAlgorithm>(const std::string&)>;
+    using LogFunction = std::function<void(const std::string&)>;
+
+    // Row callbacks for runStreaming(): a source fills the span with the next row and
+    // returns false when the image is exhausted; a sink receives each finished row.
+    using RowSource = std::function<bool(std::span<unsigned char>)>;
+    using RowSink = std::function<void(std::span<const unsigned char>)>;
+
+    // Rows are processed in bands of roughly this many bytes
+    static constexpr size_t StreamBandBytes = 4 * 1024 * 1024;
+
+    struct Step {
+        std::string algoName;
+        int count = 1;
+        std::string param;
+    };
+
+    EncryptionPipeline(AlgorithmLookup lookup, std::string defaultKey);
+
+    void setLogFunction(LogFunction logFunc) { logFunction = std::move(logFunc); }
+
+    static Step parseStep(const std::string& stepStr);
+
+    // Steps run in the order given; callers reverse the list for decryption.
+    [[nodiscard]] Image run(const Image& input, const std::vector<std::string>& steps, bool decrypt) const;
+
+    // Whether every step is pixel-local, so the image can go through runStreaming()
+    // without ever being held in memory as a whole.
+    [[nodiscard]] bool canStream(const std::vector<std::string>& steps, int channels, bool decrypt) const;
+
+    // Runs the steps over an image supplied row by row, passing each row on to `sink`
+    // once every step has been applied to it. Requires canStream().
+    void runStreaming(int width, int height, int channels, const std::vector<std::string>& steps, bool decrypt,
+                      const RowSource& source, const RowSink& sink) const;
+
+private:
+    struct Stage {
+        std::string description;
+
+        // Fused stage: kernels applied back to back on each tile (see TileExecutor).
+        std::vector<PixelKernel> kernels;
+
+        // Materialised stage
+        std::shared_ptr<CryptoAlgorithm> algorithm;
+        std::string algoName;
+        std::string key;
+        int count = 1;
+    };
+
+    [[nodiscard]] std::vector<Stage> compile(const std::vector<std::string>& steps, int channels, bool decrypt) const;
+
+    void runMaterialised(const Stage& stage, const Image& source, Image& front, Image& back, bool decrypt) const;
+
+    void log(const std::string& message) const;
+
+    AlgorithmLookup lookup;
+    std::string defaultKey;
+    LogFunction logFunction;
+};
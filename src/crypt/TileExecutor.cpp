@@ -0,0 +1,32 @@
+#include "TileExecutor.h"
+#include <algorithm>
+#include <cstring>
+
+#include "../util/thread/ThreadPool.h"
+
+namespace TileExecutor {
+
+    size_t tileSize(const int channels) {
+        const size_t pixelSize = std::max(1, channels);
+        return std::max(pixelSize, TileSize - TileSize % pixelSize);
+    }
+
+    void run(const std::span<unsigned char> pixels, const int channels, const PixelKernel& kernel) {
+        ThreadPool::instance().parallelFor(pixels.size(), tileSize(channels), [&](const size_t begin, const size_t end) {
+            kernel(pixels.subspan(begin, end - begin), begin);
+        });
+    }
+
+    void run(const unsigned char* src, const std::span<unsigned char> dst, const int channels,
+             const std::vector<PixelKernel>& kernels, const size_t offset) {
+        ThreadPool::instance().parallelFor(dst.size(), tileSize(channels), [&](const size_t begin, const size_t end) {
+            const std::span<unsigned char> tile = dst.subspan(begin, end - begin);
+            if (src != dst.data()) {
+                std::memcpy(tile.data(), src + begin, tile.size());
+            }
+            for (const auto& kernel : kernels) {
+                kernel(tile, offset + begin);
+            }
+        });
+    }
+}
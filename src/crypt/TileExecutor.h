@@ -0,0 +1,23 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "CryptoAlgorithm.h"
+
+// Runs pixel kernels over an image buffer in cache-sized, pixel-aligned tiles,
+// spreading the tiles across the shared ThreadPool.
+namespace TileExecutor {
+    // Bytes per tile; small enough to stay cache resident across a chain of kernels.
+    constexpr size_t TileSize = 64 * 1024;
+
+    // Largest multiple of `channels` that fits in TileSize.
+    size_t tileSize(int channels);
+
+    void run(std::span<unsigned char> pixels, int channels, const PixelKernel& kernel);
+
+    // Copies each tile from `src` into `dst` (unless they are the same buffer) and then
+    // applies every kernel to it while it is still in cache. `offset` is the position of
+    // dst[0] in the whole image, for callers that feed the image through in bands.
+    void run(const unsigned char* src, std::span<unsigned char> dst, int channels, const std::vector<PixelKernel>& kernels,
+             size_t offset = 0);
+}
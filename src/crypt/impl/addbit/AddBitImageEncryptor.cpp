@@ -1,23 +1,10 @@
 #include "AddBitImageEncryptor.h"
 
-void AddBitImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    output = Image(input.width, input.height, input.channels);
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = input.getPixel(x, y, c) + 1; // overflow wraps mod 256 automatically for uint8_t
-            }
-        }
-    }
-}
+#include "../../../util/simd/ByteKernels.h"
 
-void AddBitImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
-    output = Image(input.width, input.height, input.channels);
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = input.getPixel(x, y, c) - 1; // underflow wraps mod 256 automatically for uint8_t
-            }
-        }
-    }
+PixelKernel AddBitImageEncryptor::makeKernel(const std::string& key, int channels, const bool decrypt) const {
+    const unsigned char delta = decrypt ? 0xFF : 0x01;
+    return [delta](const std::span<unsigned char> block, size_t) {
+        ByteKernels::addConstant(block, delta);
+    };
 }
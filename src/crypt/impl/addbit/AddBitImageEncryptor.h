@@ -4,8 +4,8 @@
 class AddBitImageEncryptor final : public CryptoAlgorithm {
 public:
     [[nodiscard]] std::string name() const override { return "addbit"; }
-    void encrypt(const Image& input, Image& output, const std::string& key) override;
-    void decrypt(const Image& input, Image& output, const std::string& key) override;
+    [[nodiscard]] bool supportsInPlace() const override { return true; }
+    [[nodiscard]] PixelKernel makeKernel(const std::string& key, int channels, bool decrypt) const override;
     [[nodiscard]] std::vector<std::string> getEncryptionSteps(const Image& in) const override { return { "addbit:1" }; }
 };
 
@@ -1,43 +1,48 @@
 #include "AES256ImageEncryptor.h"
 #include <openssl/rand.h>
+#include <optional>
 #include <stdexcept>
 #include <iostream>
 #include "../../../util/aes/AES256Encryptor.h"
 
-static void hideBytesInImage(const std::vector<unsigned char>& data, const int startPixel, Image& img) {
-    const int totalPixels = img.width * img.height * img.channels;
-    const int bitsToHide = data.size() * 8;
+// Salt, IV and KDF parameters are hidden one bit per byte at these offsets. The parameter
+// block is only written when it differs from the legacy PBKDF2 parameters that its absence
+// implies, so default encryptions give up the LSBs of only the first 256 bytes.
+static constexpr size_t SaltOffset = 0;
+static constexpr size_t IvOffset = 128;
+static constexpr size_t KdfOffset = 256;
+static constexpr size_t SaltIvBytes = KdfOffset;
+static constexpr size_t HeaderBytes = KdfOffset + KeyDerivation::EncodedSize * 8;
 
-    if (startPixel + bitsToHide > totalPixels) {
+static void hideBytesInImage(const std::span<const unsigned char> data, const size_t startPixel, const std::span<unsigned char> pixels) {
+    const size_t bitsToHide = data.size() * 8;
+
+    if (startPixel + bitsToHide > pixels.size()) {
         throw std::runtime_error("Image too small to hide data");
     }
 
-    std::vector<unsigned char>& pixels = img.pixels;
-
-    for (int bitIdx = 0; bitIdx < bitsToHide; ++bitIdx) {
-        const int byteIdx = bitIdx / 8;
-        const int bitPos = 7 - (bitIdx % 8);
+    for (size_t bitIdx = 0; bitIdx < bitsToHide; ++bitIdx) {
+        const size_t byteIdx = bitIdx / 8;
+        const int bitPos = 7 - static_cast<int>(bitIdx % 8);
         const unsigned char bit = (data[byteIdx] >> bitPos) & 1;
 
-        const int pixelIdx = startPixel + bitIdx;
+        const size_t pixelIdx = startPixel + bitIdx;
         pixels[pixelIdx] = (pixels[pixelIdx] & 0xFE) | bit;
     }
 }
 
-static std::vector<unsigned char> extractBytesFromImage(const int startPixel, int byteCount, const Image& img) {
-    const int totalPixels = img.width * img.height * img.channels;
-    const int bitsToExtract = byteCount * 8;
+static std::vector<unsigned char> extractBytesFromImage(const size_t startPixel, const size_t byteCount, const std::span<const unsigned char> pixels) {
+    const size_t bitsToExtract = byteCount * 8;
 
-    if (startPixel + bitsToExtract > totalPixels) {
+    if (startPixel + bitsToExtract > pixels.size()) {
         throw std::runtime_error("Image too small to extract data");
     }
 
     std::vector<unsigned char> data(byteCount, 0);
-    const std::vector<unsigned char>& pixels = img.pixels;
 
-    for (int bitIdx = 0; bitIdx < bitsToExtract; ++bitIdx) {
-        const int byteIdx = bitIdx / 8;
-        const int bitPos = 7 - (bitIdx % 8);
+    for (size_t bitIdx = 0; bitIdx < bitsToExtract; ++bitIdx) {
+        const size_t byteIdx = bitIdx / 8;
+        const int bitPos = 7 - static_cast<int>(bitIdx % 8);
 
         if (pixels[startPixel + bitIdx] & 1) {
             data[byteIdx] |= (1 << bitPos);
@@ -46,71 +51,45 @@ static std::vector<unsigned char> extractBytesFromImage(const int startPixel, in
     return data;
 }
 
-void AES256ImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    if (input.width <= 0 || input.height <= 0 || input.channels <= 0) {
-        throw std::runtime_error("Invalid input image dimensions");
-    }
-
-    const int pixelCount = input.width * input.height * input.channels;
-
-    if (static_cast<int>(input.pixels.size()) != pixelCount) {
-        throw std::runtime_error("Input pixel data size mismatch");
-    }
-
-    if (pixelCount < 256) {
-        throw std::runtime_error("Image too small to hide salt and IV");
-    }
-
-    std::vector<unsigned char> salt(16);
-    std::vector<unsigned char> iv(16);
-    if (!RAND_bytes(salt.data(), 16) || !RAND_bytes(iv.data(), 16)) {
-        throw std::runtime_error("Failed to generate random salt or IV");
-    }
-
-    const AES256Encryptor aes(key, salt);
-    std::vector<unsigned char> encrypted = aes.encrypt(input.pixels, iv);
-
-    if (encrypted.size() != input.pixels.size()) {
-        throw std::runtime_error("Encryption changed data size");
-    }
-
-    output.width = input.width;
-    output.height = input.height;
-    output.channels = input.channels;
-    output.pixels = std::move(encrypted);
-
-    hideBytesInImage(salt, 0, output);
-
-    hideBytesInImage(iv, 128, output);
-}
+void AES256ImageEncryptor::transform(const std::span<unsigned char> pixels, int channels, const std::string& key, const bool decrypt) {
+    if (decrypt) {
+        if (pixels.size() < SaltIvBytes) {
+            throw std::runtime_error("Image too small to extract salt and IV");
+        }
+        const std::vector<unsigned char> salt = extractBytesFromImage(SaltOffset, 16, pixels);
+        const std::vector<unsigned char> iv = extractBytesFromImage(IvOffset, 16, pixels);
+
+        // Images written before the KDF was configurable, and ones using the legacy
+        // parameters, carry no parameter block
+        std::optional<KeyDerivation::Params> params;
+        if (pixels.size() >= HeaderBytes) {
+            params = KeyDerivation::decode(extractBytesFromImage(KdfOffset, KeyDerivation::EncodedSize, pixels));
+        }
 
-void AES256ImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
-    if (input.width <= 0 || input.height <= 0 || input.channels <= 0) {
-        throw std::runtime_error("Invalid input image dimensions");
+        const AES256Encryptor aes(key, salt, params.value_or(KeyDerivation::legacyParams()));
+        aes.transformInPlace(pixels, iv);
+        return;
     }
 
-    const int pixelCount = input.width * input.height * input.channels;
+    // The salt comes with the cached key, so repeated aes256 steps derive it only once
+    const AES256Encryptor aes(AES256Encryptor::prepareKey(key));
+    const bool storeParams = aes.kdfParams() != KeyDerivation::legacyParams();
 
-    if (static_cast<int>(input.pixels.size()) != pixelCount) {
-        throw std::runtime_error("Input pixel data size mismatch");
+    if (pixels.size() < (storeParams ? HeaderBytes : SaltIvBytes)) {
+        throw std::runtime_error(storeParams ? "Image too small to hide salt, IV and KDF parameters"
+                                             : "Image too small to hide salt and IV");
     }
 
-    if (pixelCount < 256) {
-        throw std::runtime_error("Image too small to extract salt and IV");
+    std::vector<unsigned char> iv(16);
+    if (!RAND_bytes(iv.data(), 16)) {
+        throw std::runtime_error("Failed to generate random IV");
     }
 
-    const std::vector<unsigned char> salt = extractBytesFromImage(0, 16, input);
-    const std::vector<unsigned char> iv = extractBytesFromImage(128, 16, input);
+    aes.transformInPlace(pixels, iv);
 
-    const AES256Encryptor aes(key, salt);
-    std::vector<unsigned char> decrypted = aes.decrypt(input.pixels, iv);
-
-    if (decrypted.size() != input.pixels.size()) {
-        throw std::runtime_error("Decryption changed data size");
+    hideBytesInImage(aes.salt(), SaltOffset, pixels);
+    hideBytesInImage(iv, IvOffset, pixels);
+    if (storeParams) {
+        hideBytesInImage(KeyDerivation::encode(aes.kdfParams()), KdfOffset, pixels);
     }
-
-    output.width = input.width;
-    output.height = input.height;
-    output.channels = input.channels;
-    output.pixels = std::move(decrypted);
 }
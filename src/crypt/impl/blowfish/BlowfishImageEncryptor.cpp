@@ -1,42 +1,47 @@
 #include "BlowfishImageEncryptor.h"
 #include <openssl/rand.h>
+#include <algorithm>
+#include <optional>
 #include <stdexcept>
 
 #include "../../../util/blowfish/BlowfishEncryptor.h"
 
-static void hideBytesInImage(const std::vector<unsigned char>& data, int startPixel, Image& img) {
-    const int totalPixels = img.width * img.height * img.channels;
-    const int bitsToHide = static_cast<int>(data.size()) * 8;
+// Salt, IV and KDF parameters are hidden one bit per byte at these offsets
+static constexpr size_t SaltOffset = 0;
+static constexpr size_t IvOffset = 64;
+static constexpr size_t KdfOffset = 128;
+static constexpr size_t HeaderBytes = KdfOffset + KeyDerivation::EncodedSize * 8;
 
-    if (startPixel + bitsToHide > totalPixels) {
+static void hideBytesInImage(const std::span<const unsigned char> data, const size_t startPixel, const std::span<unsigned char> pixels) {
+    const size_t bitsToHide = data.size() * 8;
+
+    if (startPixel + bitsToHide > pixels.size()) {
         throw std::runtime_error("Image too small to hide data");
     }
 
-    std::vector<unsigned char>& pixels = img.pixels;
-    for (int bitIdx = 0; bitIdx < bitsToHide; ++bitIdx) {
-        int byteIdx = bitIdx / 8;
-        int bitPos = 7 - (bitIdx % 8);
-        unsigned char bit = (data[byteIdx] >> bitPos) & 1;
+    for (size_t bitIdx = 0; bitIdx < bitsToHide; ++bitIdx) {
+        const size_t byteIdx = bitIdx / 8;
+        const int bitPos = 7 - static_cast<int>(bitIdx % 8);
+        const unsigned char bit = (data[byteIdx] >> bitPos) & 1;
 
-        int pixelIdx = startPixel + bitIdx;
+        const size_t pixelIdx = startPixel + bitIdx;
         pixels[pixelIdx] = (pixels[pixelIdx] & 0xFE) | bit;
     }
 }
 
-static std::vector<unsigned char> extractBytesFromImage(int startPixel, int byteCount, const Image& img) {
-    const int totalPixels = img.width * img.height * img.channels;
-    const int bitsToExtract = byteCount * 8;
+static std::vector<unsigned char> extractBytesFromImage(const size_t startPixel, const size_t byteCount, const std::span<const unsigned char> pixels) {
+    const size_t bitsToExtract = byteCount * 8;
 
-    if (startPixel + bitsToExtract > totalPixels) {
+    if (startPixel + bitsToExtract > pixels.size()) {
         throw std::runtime_error("Image too small to extract data");
     }
 
     std::vector<unsigned char> data(byteCount, 0);
-    const std::vector<unsigned char>& pixels = img.pixels;
 
-    for (int bitIdx = 0; bitIdx < bitsToExtract; ++bitIdx) {
-        int byteIdx = bitIdx / 8;
-        int bitPos = 7 - (bitIdx % 8);
+    for (size_t bitIdx = 0; bitIdx < bitsToExtract; ++bitIdx) {
+        const size_t byteIdx = bitIdx / 8;
+        const int bitPos = 7 - static_cast<int>(bitIdx % 8);
+
         if (pixels[startPixel + bitIdx] & 1) {
             data[byteIdx] |= (1 << bitPos);
         }
@@ -44,64 +49,54 @@ static std::vector<unsigned char> extractBytesFromImage(int startPixel, int byte
     return data;
 }
 
-void BlowfishImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    if (input.width <= 0 || input.height <= 0 || input.channels <= 0) {
-        throw std::runtime_error("Invalid input image dimensions");
-    }
-
-    int pixelCount = input.width * input.height * input.channels;
-    if (static_cast<int>(input.pixels.size()) != pixelCount) {
-        throw std::runtime_error("Input pixel data size mismatch");
-    }
-    if (pixelCount < 128) {
-        throw std::runtime_error("Image too small to hide salt and IV");
+// CFB feeds ciphertext back, so overwriting LSBs inside the stream would garble every
+// following block. The body after the header is CFB-encrypted on its own; the header
+// region has its upper seven bits masked with a keystream (CFB over zeros, i.e. OFB)
+// under the complemented IV, leaving the LSBs free for the salt, IV and parameters.
+static void maskHeaderRegion(const BlowfishEncryptor& blowfish, const std::vector<unsigned char>& iv,
+                             const std::span<unsigned char> pixels) {
+    std::vector<unsigned char> headerIv(iv.size());
+    std::ranges::transform(iv, headerIv.begin(), [](const unsigned char b) { return static_cast<unsigned char>(~b); });
+
+    std::vector<unsigned char> keystream(HeaderBytes, 0);
+    blowfish.encrypt(keystream, keystream, headerIv);
+    for (size_t i = 0; i < HeaderBytes; ++i) {
+        pixels[i] ^= keystream[i] & 0xFE;
     }
+}
 
-    // Generate 8-byte salt and 8-byte IV
-    std::vector<unsigned char> salt(8), iv(8);
-    if (!RAND_bytes(salt.data(), 8) || !RAND_bytes(iv.data(), 8)) {
-        throw std::runtime_error("Failed to generate random salt or IV");
+void BlowfishImageEncryptor::transform(const std::span<unsigned char> pixels, int channels, const std::string& key, const bool decrypt) {
+    if (pixels.size() < HeaderBytes) {
+        throw std::runtime_error(decrypt ? "Image too small to extract salt, IV and KDF parameters"
+                                         : "Image too small to hide salt, IV and KDF parameters");
     }
 
-    // Use Blowfish in CFB mode (stream cipher, no padding)
-    BlowfishEncryptor blowfish(key, salt, BlowfishEncryptor::Mode::CFB);
-    std::vector<unsigned char> encrypted = blowfish.encrypt(input.pixels, iv);
-
-    // encrypted.size() == input.pixels.size() in CFB mode
-    output.width = input.width;
-    output.height = input.height;
-    output.channels = input.channels;
-    output.pixels = std::move(encrypted);
-
-    // Hide salt then IV in LSBs of the first 128 pixels
-    hideBytesInImage(salt, 0, output);
-    hideBytesInImage(iv, 64, output);
-}
+    if (decrypt) {
+        const std::vector<unsigned char> salt = extractBytesFromImage(SaltOffset, BlowfishEncryptor::SaltSize, pixels);
+        const std::vector<unsigned char> iv = extractBytesFromImage(IvOffset, 8, pixels);
+        const std::optional<KeyDerivation::Params> params =
+            KeyDerivation::decode(extractBytesFromImage(KdfOffset, KeyDerivation::EncodedSize, pixels));
+        if (!params) {
+            throw std::runtime_error("Missing KDF parameters in Blowfish image");
+        }
 
-void BlowfishImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
-    if (input.width <= 0 || input.height <= 0 || input.channels <= 0) {
-        throw std::runtime_error("Invalid input image dimensions");
+        const BlowfishEncryptor blowfish(key, salt, BlowfishEncryptor::Mode::CFB, *params);
+        maskHeaderRegion(blowfish, iv, pixels);
+        blowfish.decrypt(pixels.subspan(HeaderBytes), pixels.subspan(HeaderBytes), iv);
+        return;
     }
 
-    int pixelCount = input.width * input.height * input.channels;
-    if (static_cast<int>(input.pixels.size()) != pixelCount) {
-        throw std::runtime_error("Input pixel data size mismatch");
-    }
-    if (pixelCount < 128) {
-        throw std::runtime_error("Image too small to extract salt and IV");
+    std::vector<unsigned char> iv(8);
+    if (!RAND_bytes(iv.data(), 8)) {
+        throw std::runtime_error("Failed to generate random IV");
     }
 
-    // Extract salt and IV
-    std::vector<unsigned char> salt = extractBytesFromImage(0, 8, input);
-    std::vector<unsigned char> iv   = extractBytesFromImage(64, 8, input);
-
-    // Use Blowfish in CFB mode (stream cipher, no padding)
-    BlowfishEncryptor blowfish(key, salt, BlowfishEncryptor::Mode::CFB);
-    std::vector<unsigned char> decrypted = blowfish.decrypt(input.pixels, iv);
+    const KeyDerivationCache::KeyPtr derived = BlowfishEncryptor::prepareKey(key);
+    const BlowfishEncryptor blowfish(derived, BlowfishEncryptor::Mode::CFB);
+    blowfish.encrypt(pixels.subspan(HeaderBytes), pixels.subspan(HeaderBytes), iv);
+    maskHeaderRegion(blowfish, iv, pixels);
 
-    // decrypted.size() == input.pixels.size()
-    output.width = input.width;
-    output.height = input.height;
-    output.channels = input.channels;
-    output.pixels = std::move(decrypted);
+    hideBytesInImage(derived->salt, SaltOffset, pixels);
+    hideBytesInImage(iv, IvOffset, pixels);
+    hideBytesInImage(KeyDerivation::encode(derived->params), KdfOffset, pixels);
 }
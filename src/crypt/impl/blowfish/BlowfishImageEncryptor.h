@@ -3,8 +3,9 @@
 
 class BlowfishImageEncryptor final : public CryptoAlgorithm {
 public:
-    void encrypt(const Image& input, Image& output, const std::string& key) override;
-    void decrypt(const Image& input, Image& output, const std::string& key) override;
     std::string name() const override { return "blowfish";}
     std::vector<std::string> getEncryptionSteps(const Image &in) const override { return {"blowfish:1"}; }
+
+    [[nodiscard]] bool supportsInPlace() const override { return true; }
+    void transform(std::span<unsigned char> pixels, int channels, const std::string& key, bool decrypt) override;
 };
@@ -16,33 +16,23 @@ std::vector<int> SwapChannelsImageEncryptor::getChannelOrder(const std::string&
     return order;
 }
 
-void SwapChannelsImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    output = Image(input.width, input.height, input.channels);
-    const auto order = getChannelOrder(key, input.channels);
-
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = input.getPixel(x, y, order[c]);
-            }
+PixelKernel SwapChannelsImageEncryptor::makeKernel(const std::string& key, const int channels, const bool decrypt) const {
+    auto order = getChannelOrder(key, channels);
+    if (decrypt) {
+        std::vector<int> inverse(channels);
+        for (int i = 0; i < channels; ++i) {
+            inverse[order[i]] = i;
         }
+        order = std::move(inverse);
     }
-}
-
-void SwapChannelsImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
-    output = Image(input.width, input.height, input.channels);
-    const auto order = getChannelOrder(key, input.channels);
 
-    std::vector<int> inverse(input.channels);
-    for (int i = 0; i < input.channels; ++i) {
-        inverse[order[i]] = i;
-    }
-
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = input.getPixel(x, y, inverse[c]);
+    return [order, channels](const std::span<unsigned char> block, size_t) {
+        std::vector<unsigned char> pixel(channels);
+        for (size_t p = 0; p + channels <= block.size(); p += channels) {
+            std::copy_n(block.begin() + p, channels, pixel.begin());
+            for (int c = 0; c < channels; ++c) {
+                block[p + c] = pixel[order[c]];
             }
         }
-    }
+    };
 }
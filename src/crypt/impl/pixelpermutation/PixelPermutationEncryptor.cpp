@@ -16,19 +16,18 @@ void PixelPermutationEncryptor::encrypt(const Image& input, Image& output, const
     std::mt19937 rng(static_cast<uint32_t>(seed));
     std::ranges::shuffle(perm, rng);
 
-    output = Image(width, height, channels);
+    output.reshape(width, height, channels);
 
-    for (int i = 0; i < totalPixels; ++i) {
-        const int srcIndex = i;
-        const int dstIndex = perm[i];
+    // Views taken once, so the copy-on-write check is not repeated for every byte
+    const std::span<const unsigned char> src = input.pixelView();
+    const std::span<unsigned char> dst = output.pixelView();
 
-        const int srcX = srcIndex % width;
-        const int srcY = srcIndex / width;
-        const int dstX = dstIndex % width;
-        const int dstY = dstIndex / width;
+    for (int i = 0; i < totalPixels; ++i) {
+        const size_t srcOffset = static_cast<size_t>(i) * channels;
+        const size_t dstOffset = static_cast<size_t>(perm[i]) * channels;
 
         for (int c = 0; c < channels; ++c) {
-            output.getPixel(dstX, dstY, c) = input.getPixel(srcX, srcY, c);
+            dst[dstOffset + c] = src[srcOffset + c];
         }
     }
 }
@@ -51,17 +50,17 @@ void PixelPermutationEncryptor::decrypt(const Image& input, Image& output, const
         inversePerm[perm[i]] = i;
     }
 
-    output = Image(width, height, channels);
+    output.reshape(width, height, channels);
+
+    const std::span<const unsigned char> src = input.pixelView();
+    const std::span<unsigned char> dst = output.pixelView();
 
     for (int k = 0; k < totalPixels; ++k) {
-        const int dstIndex = inversePerm[k];
-        const int srcX = k % width;
-        const int srcY = k / width;
-        const int dstX = dstIndex % width;
-        const int dstY = dstIndex / width;
+        const size_t srcOffset = static_cast<size_t>(k) * channels;
+        const size_t dstOffset = static_cast<size_t>(inversePerm[k]) * channels;
 
         for (int c = 0; c < channels; ++c) {
-            output.getPixel(dstX, dstY, c) = input.getPixel(srcX, srcY, c);
+            dst[dstOffset + c] = src[srcOffset + c];
         }
     }
 }
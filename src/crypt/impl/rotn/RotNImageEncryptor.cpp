@@ -1,15 +1,9 @@
 #include "RotNImageEncryptor.h"
 #include <stdexcept>
 
-namespace {
-    uint8_t rotateLeft(const uint8_t byte, const unsigned int n) {
-        return (byte << n) | (byte >> (8 - n));
-    }
-
-    uint8_t rotateRight(const uint8_t byte, const unsigned int n) {
-        return (byte >> n) | (byte << (8 - n));
-    }
+#include "../../../util/simd/ByteKernels.h"
 
+namespace {
     unsigned int parseRotationAmount(const std::string& key) {
         const size_t hashed = std::hash<std::string>{}(key);
 
@@ -22,26 +16,11 @@ namespace {
     }
 }
 
-void RotNImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    const unsigned int n = parseRotationAmount(key);
-    output = Image(input.width, input.height, input.channels);
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = rotateLeft(input.getPixel(x, y, c), n);
-            }
-        }
-    }
-}
-
-void RotNImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
+PixelKernel RotNImageEncryptor::makeKernel(const std::string& key, int channels, const bool decrypt) const {
+    // Rotating right by n is rotating left by 8 - n
     const unsigned int n = parseRotationAmount(key);
-    output = Image(input.width, input.height, input.channels);
-    for (int y = 0; y < input.height; ++y) {
-        for (int x = 0; x < input.width; ++x) {
-            for (int c = 0; c < input.channels; ++c) {
-                output.getPixel(x, y, c) = rotateRight(input.getPixel(x, y, c), n);
-            }
-        }
-    }
+    const unsigned int left = decrypt ? 8 - n : n;
+    return [left](const std::span<unsigned char> block, size_t) {
+        ByteKernels::rotateLeft(block, left);
+    };
 }
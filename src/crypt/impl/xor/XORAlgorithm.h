@@ -4,7 +4,7 @@
 class XORImageEncryptor final : public CryptoAlgorithm {
 public:
     [[nodiscard]] std::string name() const override { return "xor"; }
-    void encrypt(const Image& input, Image& output, const std::string& key) override;
-    void decrypt(const Image& input, Image& output, const std::string& key) override;
+    [[nodiscard]] bool supportsInPlace() const override { return true; }
+    [[nodiscard]] PixelKernel makeKernel(const std::string& key, int channels, bool decrypt) const override;
     [[nodiscard]] std::vector<std::string> getEncryptionSteps(const Image& in) const override { return { "xor:1" };}
 };
\ No newline at end of file
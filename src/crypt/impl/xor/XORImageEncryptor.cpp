@@ -1,29 +1,17 @@
 #include "XORAlgorithm.h"
+#include <memory>
 #include <stdexcept>
-#include <random>
 
-static uint8_t byteFromKey(const std::string& key, const int pos) {
-    return static_cast<uint8_t>(key[pos % key.size()]);
-}
+#include "../../../util/simd/ByteKernels.h"
 
-void XORImageEncryptor::encrypt(const Image& input, Image& output, const std::string& key) {
-    if (input.pixels.empty())
-        throw std::runtime_error("Input image is empty.");
+PixelKernel XORImageEncryptor::makeKernel(const std::string& key, int channels, bool decrypt) const {
+    if (key.empty())
+        throw std::runtime_error("XOR key must not be empty.");
 
-    const int totalBytes = input.width * input.height * input.channels;
-    output.width = input.width;
-    output.height = input.height;
-    output.channels = input.channels;
-    output.pixels.resize(totalBytes);
+    const auto keyStream = std::make_shared<ByteKernels::RepeatingKey>(
+        std::span(reinterpret_cast<const unsigned char*>(key.data()), key.size()));
 
-    // XOR each byte with key-derived stream
-    for (int i = 0; i < totalBytes; ++i) {
-        const uint8_t k = byteFromKey(key, i);
-        output.pixels[i] = input.pixels[i] ^ k;
-    }
+    return [keyStream](const std::span<unsigned char> block, const size_t offset) {
+        ByteKernels::xorRepeatingKey(block, *keyStream, offset);
+    };
 }
-
-void XORImageEncryptor::decrypt(const Image& input, Image& output, const std::string& key) {
-    // XOR is its own inverse
-    encrypt(input, output, key);
-}
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "HnsContainer.h"
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../util/mmap/MappedFile.h"
+#include "../util/thread/ThreadPool.h"
+
+namespace HnsContainer {
+
+    namespace {
+        constexpr std::array<unsigned char, 8> Magic = { 0x89, 'H', 'N', 'S', '\r', '\n', 0x1A, '\n' };
+
+        // Pixels are checksummed in slices of this size across the pool and the CRCs combined
+        constexpr size_t ChecksumSlice = 4 * 1024 * 1024;
+
+        void put32(unsigned char* p, const uint32_t value) {
+            for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(value >> (i * 8));
+        }
+
+        void put64(unsigned char* p, const uint64_t value) {
+            for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(value >> (i * 8));
+        }
+
+        uint32_t get32(const unsigned char* p) {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(p[i]) << (i * 8);
+            return value;
+        }
+
+        uint64_t get64(const unsigned char* p) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(p[i]) << (i * 8);
+            return value;
+        }
+
+        uint32_t checksum(const std::span<const unsigned char> data) {
+            const size_t slices = (data.size() + ChecksumSlice - 1) / ChecksumSlice;
+            std::vector<uLong> crcs(slices);
+
+            ThreadPool::instance().parallelFor(slices, 1, [&](const size_t begin, const size_t end) {
+                for (size_t s = begin; s < end; ++s) {
+                    const auto slice = data.subspan(s * ChecksumSlice, std::min(ChecksumSlice, data.size() - s * ChecksumSlice));
+                    crcs[s] = crc32_z(crc32_z(0L, nullptr, 0), slice.data(), slice.size());
+                }
+            });
+
+            uLong crc = crc32_z(0L, nullptr, 0);
+            for (size_t s = 0; s < slices; ++s) {
+                const size_t length = std::min(ChecksumSlice, data.size() - s * ChecksumSlice);
+                crc = crc32_combine(crc, crcs[s], static_cast<z_off_t>(length));
+            }
+            return static_cast<uint32_t>(crc);
+        }
+
+        std::vector<unsigned char> encodeMetadata(const std::map<std::string, std::string>& metadata) {
+            std::vector<unsigned char> block(4);
+            put32(block.data(), static_cast<uint32_t>(metadata.size()));
+
+            auto append = [&](const std::string& text) {
+                const size_t at = block.size();
+                block.resize(at + 4 + text.size());
+                put32(block.data() + at, static_cast<uint32_t>(text.size()));
+                std::memcpy(block.data() + at + 4, text.data(), text.size());
+            };
+            for (const auto& [key, value] : metadata) {
+                append(key);
+                append(value);
+            }
+            return block;
+        }
+
+        void decodeMetadata(const std::span<const unsigned char> block, Image& img) {
+            size_t at = 0;
+            auto take = [&](const size_t n) {
+                if (block.size() - at < n) {
+                    throw std::runtime_error("Corrupt metadata block");
+                }
+                const unsigned char* p = block.data() + at;
+                at += n;
+                return p;
+            };
+            auto text = [&] {
+                const uint32_t length = get32(take(4));
+                return std::string(reinterpret_cast<const char*>(take(length)), length);
+            };
+
+            const uint32_t count = get32(take(4));
+            for (uint32_t i = 0; i < count; ++i) {
+                std::string key = text();
+                img.metadata()[std::move(key)] = text();
+            }
+        }
+    }
+
+    bool hasExtension(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+        return extension == ".hns";
+    }
+
+    bool isContainer(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::array<unsigned char, Magic.size()> magic{};
+        return file.read(reinterpret_cast<char*>(magic.data()), magic.size()) && magic == Magic;
+    }
+
+    void write(const std::filesystem::path& path, const Image& img) {
+        const std::span<const unsigned char> pixels = img.pixelView();
+        if (pixels.size() != static_cast<size_t>(img.width) * img.height * img.channels) {
+            throw std::runtime_error("Error: image buffer does not match its dimensions");
+        }
+
+        const std::vector<unsigned char> metadata = encodeMetadata(img.metadata());
+        const size_t pixelOffset = (HeaderSize + metadata.size() + PixelAlignment - 1) / PixelAlignment * PixelAlignment;
+
+        std::array<unsigned char, HeaderSize> header{};
+        std::ranges::copy(Magic, header.begin());
+        put32(&header[8], Version);
+        put32(&header[12], HeaderSize);
+        put32(&header[16], static_cast<uint32_t>(img.width));
+        put32(&header[20], static_cast<uint32_t>(img.height));
+        put32(&header[24], static_cast<uint32_t>(img.channels));
+        put64(&header[32], HeaderSize);
+        put64(&header[40], metadata.size());
+        put64(&header[48], pixelOffset);
+        put64(&header[56], pixels.size());
+        put32(&header[64], static_cast<uint32_t>(crc32_z(0L, metadata.data(), metadata.size())));
+        put32(&header[68], checksum(pixels));
+        put32(&header[124], static_cast<uint32_t>(crc32_z(0L, header.data(), 124)));
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Error: could not write image to " + path.string());
+        }
+
+        const std::vector<char> padding(pixelOffset - HeaderSize - metadata.size(), 0);
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        file.write(reinterpret_cast<const char*>(metadata.data()), static_cast<std::streamsize>(metadata.size()));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+        if (!file.flush()) {
+            throw std::runtime_error("Error: could not write image to " + path.string());
+        }
+    }
+
+    namespace {
+        struct Layout {
+            uint32_t width;
+            uint32_t height;
+            uint32_t channels;
+            uint64_t metadataOffset;
+            uint64_t metadataSize;
+            uint64_t pixelOffset;
+            uint64_t pixelSize;
+            uint32_t metadataCrc;
+            uint32_t pixelCrc;
+        };
+
+        Layout parseHeader(const std::span<const unsigned char> header, const uint64_t fileSize,
+                           const std::filesystem::path& path) {
+            if (header.size() < HeaderSize || !std::equal(Magic.begin(), Magic.end(), header.begin())) {
+                throw std::runtime_error("Error: not a HideNSeek container: " + path.string());
+            }
+            if (get32(&header[124]) != static_cast<uint32_t>(crc32_z(0L, header.data(), 124))) {
+                throw std::runtime_error("Error: container header is corrupt: " + path.string());
+            }
+            if (get32(&header[8]) != Version) {
+                throw std::runtime_error("Error: unsupported container version " + std::to_string(get32(&header[8])));
+            }
+
+            const Layout layout{
+                .width = get32(&header[16]),
+                .height = get32(&header[20]),
+                .channels = get32(&header[24]),
+                .metadataOffset = get64(&header[32]),
+                .metadataSize = get64(&header[40]),
+                .pixelOffset = get64(&header[48]),
+                .pixelSize = get64(&header[56]),
+                .metadataCrc = get32(&header[64]),
+                .pixelCrc = get32(&header[68])
+            };
+
+            if (layout.channels < 1 || layout.channels > 4 || layout.width > INT32_MAX || layout.height > INT32_MAX ||
+                layout.pixelSize != static_cast<uint64_t>(layout.width) * layout.height * layout.channels ||
+                layout.metadataOffset < HeaderSize || layout.metadataOffset > layout.pixelOffset ||
+                layout.metadataSize > layout.pixelOffset - layout.metadataOffset ||
+                layout.pixelOffset > fileSize || layout.pixelSize > fileSize - layout.pixelOffset) {
+                throw std::runtime_error("Error: container header is inconsistent: " + path.string());
+            }
+            return layout;
+        }
+
+        void readMetadata(const std::span<const unsigned char> block, const Layout& layout, Image& img,
+                          const std::filesystem::path& path) {
+            if (layout.metadataCrc != static_cast<uint32_t>(crc32_z(0L, block.data(), block.size()))) {
+                throw std::runtime_error("Error: container metadata is corrupt: " + path.string());
+            }
+            decodeMetadata(block, img);
+        }
+    }
+
+    Image read(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::array<unsigned char, HeaderSize> header{};
+        if (!file.read(reinterpret_cast<char*>(header.data()), header.size())) {
+            throw std::runtime_error("Error: not a HideNSeek container: " + path.string());
+        }
+        const Layout layout = parseHeader(header, std::filesystem::file_size(path), path);
+
+        std::vector<unsigned char> metadata(layout.metadataSize);
+        file.seekg(static_cast<std::streamoff>(layout.metadataOffset));
+        if (!file.read(reinterpret_cast<char*>(metadata.data()), static_cast<std::streamsize>(metadata.size()))) {
+            throw std::runtime_error("Error: container metadata is corrupt: " + path.string());
+        }
+
+        Image img;
+        readMetadata(metadata, layout, img, path);
+
+        // The pixel block is read straight into the image buffer
+        img.reshape(static_cast<int>(layout.width), static_cast<int>(layout.height), static_cast<int>(layout.channels));
+        const std::span<unsigned char> pixels = img.pixelView();
+        file.seekg(static_cast<std::streamoff>(layout.pixelOffset));
+        if (!file.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size())) ||
+            layout.pixelCrc != checksum(pixels)) {
+            throw std::runtime_error("Error: container pixels are corrupt: " + path.string());
+        }
+        return img;
+    }
+
+    Image map(const std::filesystem::path& path) {
+        const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+        const std::span<unsigned char> bytes = file->view();
+        const Layout layout = parseHeader(bytes, bytes.size(), path);
+
+        Image img;
+        readMetadata(bytes.subspan(layout.metadataOffset, layout.metadataSize), layout, img, path);
+
+        // The mapping stays alive for as long as any copy of the pixel buffer refers to it
+        img.width = static_cast<int>(layout.width);
+        img.height = static_cast<int>(layout.height);
+        img.channels = static_cast<int>(layout.channels);
+        img.pixels = PixelBuffer::adopt(bytes.data() + layout.pixelOffset, layout.pixelSize,
+                                        [file](unsigned char*) {});
+        return img;
+    }
+}
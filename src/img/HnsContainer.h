@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "Image.h"
+
+// HideNSeek's own lossless image container (".hns"), meant for intermediate and encrypted
+// images that gain nothing from PNG compression. Little-endian layout:
+//
+//   0    magic "\x89HNS\r\n\x1a\n"
+//   8    u32 version, u32 header size (128)
+//   16   u32 width, u32 height, u32 channels, u32 flags (0)
+//   32   u64 metadata offset, u64 metadata size
+//   48   u64 pixel offset, u64 pixel size
+//   64   u32 metadata CRC-32, u32 pixel CRC-32
+//   72   reserved, zero
+//   124  u32 CRC-32 of bytes 0-123
+//
+// The metadata block holds a u32 entry count followed by length-prefixed key/value
+// strings. Pixels start on a 64-byte boundary, so a mapping of the file can be used
+// as the pixel buffer as it is.
+namespace HnsContainer {
+    constexpr uint32_t Version = 1;
+    constexpr size_t HeaderSize = 128;
+    constexpr size_t PixelAlignment = 64;
+
+    // Whether the path ends in ".hns"; such outputs are written as containers
+    bool hasExtension(const std::filesystem::path& path);
+
+    // Whether the file starts with the container magic
+    bool isContainer(const std::filesystem::path& path);
+
+    void write(const std::filesystem::path& path, const Image& img);
+
+    // Throws std::runtime_error for anything that is not an intact version 1 container
+    Image read(const std::filesystem::path& path);
+
+    // Like read(), but the pixels are a copy-on-write mapping of the file, paged in as they
+    // are touched. Header and metadata are verified; the pixel checksum is not, since that
+    // would read every page.
+    Image map(const std::filesystem::path& path);
+}
@@ -1,14 +1,18 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include <string>
 #include <map>
 
+#include "PixelBuffer.h"
+
 struct Image {
     int width;
     int height;
     int channels;
-    std::vector<unsigned char> pixels;
+    // Shared with copies of this image until either side writes to it
+    PixelBuffer pixels;
 
     std::map<std::string, std::string>& metadata() {
         return meta;
@@ -33,11 +37,30 @@ struct Image {
     }
 
     [[nodiscard]] std::vector<unsigned char> getPixels() const {
-        return pixels;
+        return { pixels.begin(), pixels.end() };
     }
 
     void setPixels(const std::vector<unsigned char>& toSet) {
-        pixels = toSet;
+        pixels.assign(toSet.begin(), toSet.end());
+    }
+
+    // Views over the pixel buffer for callers that read or write in place instead of copying
+    [[nodiscard]] std::span<unsigned char> pixelView() { return pixels; }
+    [[nodiscard]] std::span<const unsigned char> pixelView() const { return pixels; }
+
+    // Changes the dimensions, keeping the existing allocation where possible.
+    // Pixel contents are unspecified afterwards; callers are expected to overwrite them.
+    void reshape(const int w, const int h, const int c) {
+        width = w;
+        height = h;
+        channels = c;
+        const size_t size = static_cast<size_t>(w) * h * c;
+        // A shared buffer would be copied only to be overwritten, so it is replaced instead
+        if (pixels.shared()) {
+            pixels = PixelBuffer(size);
+        } else {
+            pixels.resize(size);
+        }
     }
 
     void addMetadata(const std::string& key, const std::string& value) {
@@ -63,7 +86,7 @@ struct Image {
 
     explicit Image(const int w = 0, const int h = 0, const int c = 1)
       : width(w), height(h), channels(c),
-        pixels(static_cast<size_t>(w) * h * c, 0) {}
+        pixels(static_cast<size_t>(w) * h * c) {}
 
 private:
     std::map<std::string, std::string> meta;
@@ -1,15 +1,40 @@
 #include "ImageLoader.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
+#include <cctype>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <optional>
 
+#include "HnsContainer.h"
 #include "ImageUtils.h"
+#include "PngStream.h"
+#include "../util/mmap/MappedFile.h"
+
+// Empty until setLogFunction; std::cout and std::cerr stand in for it until then
+static std::optional<ImageLoader::LogFunction> logFunction;
+
+static void logMessage(const std::string& message, const bool warning = false) {
+    if (!logFunction) {
+        (warning ? std::cerr : std::cout) << message << std::endl;
+    } else if (*logFunction) {
+        (*logFunction)(message);
+    }
+}
+
+static std::string describe(const Image& img) {
+    return " (" + std::to_string(img.width) + "x" + std::to_string(img.height) +
+           ", channels=" + std::to_string(img.channels) +
+           ", metadata entries=" + std::to_string(img.metadata().size()) + ")";
+}
+
+void ImageLoader::setLogFunction(LogFunction logFunc) {
+    logFunction = std::move(logFunc);
+}
 
 static std::string hashImage(const Image& image) {
     const auto size = image.pixels.size();
@@ -21,7 +46,7 @@ static std::string hashImage(const Image& image) {
     return oss.str();
 }
 
-void loadMetadataFromFile(const std::filesystem::path &path, Image &img) {
+static void loadMetadataFromFile(const std::filesystem::path &path, Image &img) {
     auto metaPath = path;
     metaPath.replace_extension(path.extension().string() + ".meta");
 
@@ -31,7 +56,7 @@ void loadMetadataFromFile(const std::filesystem::path &path, Image &img) {
 
     std::ifstream metaFile(metaPath);
     if (!metaFile.is_open()) {
-        std::cerr << "Warning: Could not open metadata file: " << metaPath << std::endl;
+        logMessage("Warning: Could not open metadata file: " + metaPath.string(), true);
         return;
     }
 
@@ -46,10 +71,10 @@ void loadMetadataFromFile(const std::filesystem::path &path, Image &img) {
         }
     }
 
-    std::cout << "Loaded " << img.metadata().size() << " metadata entries from " << metaPath << std::endl;
+    logMessage("Loaded " + std::to_string(img.metadata().size()) + " metadata entries from " + metaPath.string());
 }
 
-void saveMetadataToFile(const std::filesystem::path &path, const Image &img) {
+static void saveMetadataToFile(const std::filesystem::path &path, const Image &img) {
     if (img.metadata().empty()) {
         return;
     }
@@ -59,7 +84,7 @@ void saveMetadataToFile(const std::filesystem::path &path, const Image &img) {
 
     std::ofstream metaFile(metaPath);
     if (!metaFile.is_open()) {
-        std::cerr << "Warning: Could not open metadata file for writing: " << metaPath << std::endl;
+        logMessage("Warning: Could not open metadata file for writing: " + metaPath.string(), true);
         return;
     }
 
@@ -67,7 +92,7 @@ void saveMetadataToFile(const std::filesystem::path &path, const Image &img) {
         metaFile << key << "=" << value << std::endl;
     }
 
-    std::cout << "Saved " << img.metadata().size() << " metadata entries to " << metaPath << std::endl;
+    logMessage("Saved " + std::to_string(img.metadata().size()) + " metadata entries to " + metaPath.string());
 }
 
 Image ImageLoader::loadImage(const std::filesystem::path &path) {
@@ -76,55 +101,150 @@ Image ImageLoader::loadImage(const std::filesystem::path &path) {
     }
 
     Image img;
-    int w, h, c;
-    unsigned char* data = stbi_load(path.string().c_str(), &w, &h, &c, 3);
-    if (!data) {
-        throw std::runtime_error("Error: could not load image: " + path.string());
+    const char* decoder = "png stream";
+
+    if (HnsContainer::isContainer(path)) {
+        // Metadata travels inside the container, so there is no sidecar to read
+        decoder = "container";
+        img = HnsContainer::read(path);
+    } else if (PngReader::supports(path)) {
+        // Rows are decoded straight into the image, with no intermediate full-size buffer
+        PngReader reader(path);
+        img.reshape(reader.width(), reader.height(), reader.channels());
+        const std::span<unsigned char> pixels = img.pixelView();
+        while (reader.readRow(pixels.subspan(reader.rowsRead() * reader.rowBytes()))) {}
+        loadMetadataFromFile(path, img);
+    } else {
+        decoder = "stb";
+        int w, h, c;
+        unsigned char* data = stbi_load(path.string().c_str(), &w, &h, &c, 0);
+        if (!data) {
+            throw std::runtime_error("Error: could not load image: " + path.string());
+        }
+        img.width = w;
+        img.height = h;
+        img.channels = c;
+        // The image takes over stb's buffer rather than copying it
+        img.pixels = PixelBuffer::adopt(data, static_cast<size_t>(w) * h * c,
+                                        [](unsigned char* p) { stbi_image_free(p); });
+        loadMetadataFromFile(path, img);
     }
-    img.width = w;
-    img.height = h;
-    img.channels = 3;
-    img.pixels.assign(data, data + (w * h * 3));
-    stbi_image_free(data);
 
-    loadMetadataFromFile(path, img);
+    logMessage("Successfully loaded image via " + std::string(decoder) + ": " + path.string() + describe(img));
+    return img;
+}
+
+// Binary PGM (P5) or PPM (P6) with 8-bit samples: a short text header followed by the
+// pixels exactly as Image lays them out. Returns false for anything else.
+static bool mapNetpbm(const std::filesystem::path &path, Image &img) {
+    std::ifstream probe(path, std::ios::binary);
+    char magic[2] = {};
+    if (!probe.read(magic, 2) || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+        return false;
+    }
+
+    const std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    const std::span<unsigned char> bytes = file->view();
+    size_t at = 2;
+
+    // Width, height and maxval, separated by whitespace and '#' comments
+    auto field = [&]() -> int64_t {
+        while (at < bytes.size()) {
+            if (bytes[at] == '#') {
+                while (at < bytes.size() && bytes[at] != '\n') ++at;
+            } else if (std::isspace(bytes[at])) {
+                ++at;
+            } else {
+                break;
+            }
+        }
+        int64_t value = 0;
+        const size_t start = at;
+        while (at < bytes.size() && std::isdigit(bytes[at]) && value <= INT32_MAX) {
+            value = value * 10 + (bytes[at++] - '0');
+        }
+        return at == start ? -1 : value;
+    };
+
+    const int64_t width = field();
+    const int64_t height = field();
+    const int64_t maxValue = field();
+    // Exactly one whitespace byte separates the header from the pixels
+    if (width <= 0 || height <= 0 || width > INT32_MAX || height > INT32_MAX || maxValue != 255 ||
+        at >= bytes.size() || !std::isspace(bytes[at])) {
+        return false;
+    }
+    ++at;
+
+    const int channels = magic[1] == '5' ? 1 : 3;
+    const size_t size = static_cast<size_t>(width) * height * channels;
+    if (bytes.size() - at < size) {
+        throw std::runtime_error("Error: truncated image file: " + path.string());
+    }
 
-    std::cout << "Successfully loaded image via stb: " << path
-              << " (" << img.width << "x" << img.height
-              << ", channels=" << img.channels
-              << ", metadata entries=" << img.metadata().size() << ")\n";
+    img.width = static_cast<int>(width);
+    img.height = static_cast<int>(height);
+    img.channels = channels;
+    img.pixels = PixelBuffer::adopt(bytes.data() + at, size, [file](unsigned char*) {});
+    return true;
+}
+
+Image ImageLoader::mapImage(const std::filesystem::path &path) {
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Error: Path does not exist: " + path.string());
+    }
+
+    Image img;
+    if (HnsContainer::isContainer(path)) {
+        img = HnsContainer::map(path);
+    } else if (mapNetpbm(path, img)) {
+        loadMetadataFromFile(path, img);
+    } else {
+        return loadImage(path);
+    }
+
+    logMessage("Successfully mapped image: " + path.string() + describe(img));
     return img;
 }
 
 void ImageLoader::saveImage(const std::filesystem::path &path,
-                            Image &img,
-                            const bool hash) {
+                            const Image &img,
+                            const bool hash,
+                            const PngEncoding &encoding) {
     if (img.pixels.empty()) {
         throw std::runtime_error("Error: cannot save empty image");
     }
-    if (img.channels != 3) {
-        img = ImageUtils::convertTo3Channels(img);
-    }
 
     const std::string outPath = hash
         ? (path.parent_path() /
            (path.stem().string() + "_" + hashImage(img) + path.extension().string())).string()
         : path.string();
 
-    std::cout << ">>> Saving image via stb: " << outPath
-              << " (" << img.width << "x" << img.height
-              << ", channels=" << img.channels
-              << ", metadata entries=" << img.metadata().size() << ")" << std::endl;
+    logMessage(">>> Saving image: " + outPath + describe(img));
 
-    if (!stbi_write_png(outPath.c_str(),
-                        img.width, img.height, img.channels,
-                        img.pixels.data(),
-                        img.width * img.channels))
-    {
-        throw std::runtime_error("Error: could not write image to " + outPath);
+    if (HnsContainer::hasExtension(outPath)) {
+        HnsContainer::write(outPath, img);
+        logMessage("Successfully saved container: " + outPath);
+        return;
     }
 
+    const std::span<const unsigned char> pixels = img.pixelView();
+    const size_t rowBytes = static_cast<size_t>(img.width) * img.channels;
+
+    PngWriter writer(outPath, img.width, img.height, img.channels, encoding);
+    for (int y = 0; y < img.height; ++y) {
+        writer.writeRow(pixels.subspan(y * rowBytes, rowBytes));
+    }
+    writer.finish();
+
     saveMetadataToFile(outPath, img);
 
-    std::cout << "Successfully saved image via stb: " << outPath << std::endl;
-}
\ No newline at end of file
+    logMessage("Successfully saved image: " + outPath);
+}
+void ImageLoader::loadMetadata(const std::filesystem::path &path, Image &img) {
+    loadMetadataFromFile(path, img);
+}
+
+void ImageLoader::saveMetadata(const std::filesystem::path &path, const Image &img) {
+    saveMetadataToFile(path, img);
+}
@@ -1,13 +1,37 @@
 #pragma once
 
 #include "Image.h"
+#include "PngStream.h"
 #include <filesystem>
+#include <functional>
+#include <string>
 
 class ImageLoader {
 public:
+    using LogFunction = std::function<void(const std::string&)>;
+
+    // Where load and save messages go: std::cout (warnings std::cerr) until set, nowhere once
+    // set to an empty function. Set it before images are loaded from several threads; the
+    // function itself is then called from all of them.
+    static void setLogFunction(LogFunction logFunc);
+
+    // Keeps the file's own channel count (gray, gray+alpha, RGB or RGBA); callers that need
+    // RGB convert with ImageUtils::convertTo3Channels.
     static Image loadImage(const std::filesystem::path &path);
 
+    // Like loadImage, but .hns containers and binary PGM/PPM files are memory-mapped rather
+    // than read, so callers that look at only part of the pixels (LSB extraction, say) only
+    // page in that part. Other formats are loaded as usual.
+    static Image mapImage(const std::filesystem::path &path);
+
+    // Writes the image with its own channel count: as a .hns container when the path has
+    // that extension (metadata included), otherwise as PNG with a .meta sidecar
     static void saveImage(const std::filesystem::path &path,
-                          Image &img,
-                          bool hash = false);
+                          const Image &img,
+                          bool hash = false,
+                          const PngEncoding &encoding = {});
+
+    // The "<file>.meta" sidecar that accompanies an image, for callers that stream the pixels themselves
+    static void loadMetadata(const std::filesystem::path &path, Image &img);
+    static void saveMetadata(const std::filesystem::path &path, const Image &img);
 };
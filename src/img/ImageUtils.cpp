@@ -1,6 +1,7 @@
 #include "ImageUtils.h"
 #include "../util/base64/Base64.h"
 
+#include <algorithm>
 #include <iostream>
 #include <ranges>
 #include <sstream>
@@ -26,8 +27,8 @@ namespace ImageUtils {
     }
 
     Image convertTo3Channels(const Image& src) {
-        if (src.channels == 3) return src;
-        if (src.channels != 1 && src.channels != 4) {
+        if (src.channels == 3) return src; // shares the pixel buffer
+        if (src.channels < 1 || src.channels > 4) {
             throw std::runtime_error("Unsupported channel count: " + std::to_string(src.channels));
         }
 
@@ -37,18 +38,21 @@ namespace ImageUtils {
         result.channels = 3;
         result.pixels.resize(src.width * src.height * 3);
 
-        if (src.channels == 1) {
+        const unsigned char* in = src.pixels.data();
+        unsigned char* out = result.pixels.data();
+        if (src.channels <= 2) {
+            // Gray, with or without alpha; the alpha channel is dropped
             for (int i = 0; i < src.width * src.height; ++i) {
-                const unsigned char gray = src.pixels[i];
-                result.pixels[i * 3 + 0] = gray;
-                result.pixels[i * 3 + 1] = gray;
-                result.pixels[i * 3 + 2] = gray;
+                const unsigned char gray = in[i * src.channels];
+                out[i * 3 + 0] = gray;
+                out[i * 3 + 1] = gray;
+                out[i * 3 + 2] = gray;
             }
         } else if (src.channels == 4) {
             for (int i = 0; i < src.width * src.height; ++i) {
-                result.pixels[i * 3 + 0] = src.pixels[i * 4 + 0]; // R
-                result.pixels[i * 3 + 1] = src.pixels[i * 4 + 1]; // G
-                result.pixels[i * 3 + 2] = src.pixels[i * 4 + 2]; // B
+                out[i * 3 + 0] = in[i * 4 + 0]; // R
+                out[i * 3 + 1] = in[i * 4 + 1]; // G
+                out[i * 3 + 2] = in[i * 4 + 2]; // B
             }
         }
 
@@ -176,7 +180,9 @@ namespace ImageUtils {
     }
 
     std::vector<unsigned char> serializeImage(const Image& img) {
+        const auto pixels = img.pixelView();
         std::vector<unsigned char> data;
+        data.reserve(12 + pixels.size());
 
         auto appendUint32 = [&](const uint32_t val) {
             for (int i = 0; i < 4; ++i)
@@ -188,7 +194,6 @@ namespace ImageUtils {
         appendUint32(img.channels);
 
         // Append pixel data
-        const auto& pixels = img.getPixels();
         data.insert(data.end(), pixels.begin(), pixels.end());
 
         return data;
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+// Reference-counted pixel storage. Copies share the same bytes until one of them is
+// written through a non-const accessor, which first takes a private copy. Read through
+// a const reference to avoid copying by accident.
+class PixelBuffer {
+public:
+    using value_type = unsigned char;
+    using iterator = unsigned char*;
+    using const_iterator = const unsigned char*;
+
+    PixelBuffer() = default;
+
+    explicit PixelBuffer(const size_t size, const unsigned char value = 0)
+        : bytes(allocate(size)), length(size), capacity(size) {
+        std::fill_n(bytes.get(), size, value);
+    }
+
+    // Takes over `size` bytes allocated elsewhere (by a decoder, say) instead of copying
+    // them; `deleter` releases them once no buffer refers to them any more.
+    template<typename Deleter>
+    static PixelBuffer adopt(unsigned char* data, const size_t size, Deleter deleter) {
+        PixelBuffer buffer;
+        buffer.bytes = std::shared_ptr<unsigned char[]>(data, std::move(deleter));
+        buffer.length = size;
+        buffer.capacity = size;
+        return buffer;
+    }
+
+    [[nodiscard]] size_t size() const { return length; }
+    [[nodiscard]] bool empty() const { return length == 0; }
+
+    // Whether another buffer currently shares these bytes
+    [[nodiscard]] bool shared() const { return bytes.use_count() > 1; }
+
+    [[nodiscard]] const unsigned char* data() const { return bytes.get(); }
+    [[nodiscard]] unsigned char* data() { return unique(); }
+
+    [[nodiscard]] const_iterator begin() const { return data(); }
+    [[nodiscard]] const_iterator end() const { return data() + size(); }
+    [[nodiscard]] iterator begin() { return data(); }
+    [[nodiscard]] iterator end() { return data() + size(); }
+
+    [[nodiscard]] const unsigned char& operator[](const size_t i) const { return bytes[i]; }
+    [[nodiscard]] unsigned char& operator[](const size_t i) { return unique()[i]; }
+
+    // Like std::vector::resize: existing bytes are kept, new ones are zeroed
+    void resize(const size_t size) {
+        if (shared() || size > capacity) {
+            reallocate(size > capacity ? std::max(size, 2 * capacity) : capacity);
+        }
+        if (size > length) {
+            std::fill(bytes.get() + length, bytes.get() + size, 0);
+        }
+        length = size;
+    }
+
+    template<typename It>
+    void assign(It first, It last) {
+        const auto size = static_cast<size_t>(std::distance(first, last));
+        if (shared() || size > capacity) {
+            bytes = allocate(size);
+            capacity = size;
+        }
+        std::copy(first, last, bytes.get());
+        length = size;
+    }
+
+    friend bool operator==(const PixelBuffer& a, const PixelBuffer& b) {
+        return (a.bytes == b.bytes && a.length == b.length) || std::ranges::equal(a, b);
+    }
+
+private:
+    static std::shared_ptr<unsigned char[]> allocate(const size_t size) {
+        return std::make_shared_for_overwrite<unsigned char[]>(size);
+    }
+
+    unsigned char* unique() {
+        if (shared()) {
+            reallocate(capacity);
+        }
+        return bytes.get();
+    }
+
+    void reallocate(const size_t newCapacity) {
+        std::shared_ptr<unsigned char[]> replacement = allocate(newCapacity);
+        std::copy_n(bytes.get(), std::min(length, newCapacity), replacement.get());
+        bytes = std::move(replacement);
+        capacity = newCapacity;
+    }
+
+    std::shared_ptr<unsigned char[]> bytes;
+    size_t length = 0;
+    size_t capacity = 0;
+};
@@ -0,0 +1,505 @@
+#include "PngStream.h"
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "../util/thread/ThreadPool.h"
+
+namespace {
+    constexpr std::array<unsigned char, 8> Signature = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    // Compressed bytes read or written per file access; also the IDAT chunk size on output
+    constexpr size_t IoBufferSize = 256 * 1024;
+
+    // Filtered bytes per independently deflated block, and the deflate window primed into each
+    constexpr size_t DeflateBlockSize = 1024 * 1024;
+    constexpr size_t DeflateWindow = 32 * 1024;
+
+    enum Filter : unsigned char { None = 0, Sub = 1, Up = 2, Average = 3, Paeth = 4 };
+
+    uint32_t readBE32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+               static_cast<uint32_t>(p[2]) << 8 | p[3];
+    }
+
+    void writeBE32(unsigned char* p, const uint32_t value) {
+        p[0] = static_cast<unsigned char>(value >> 24);
+        p[1] = static_cast<unsigned char>(value >> 16);
+        p[2] = static_cast<unsigned char>(value >> 8);
+        p[3] = static_cast<unsigned char>(value);
+    }
+
+    struct Header {
+        uint32_t width;
+        uint32_t height;
+        int bitDepth;
+        int colorType;
+        int compression;
+        int filter;
+        int interlace;
+    };
+
+    int channelsFor(const int colorType) {
+        switch (colorType) {
+            case 0: return 1;  // grayscale
+            case 2: return 3;  // RGB
+            case 4: return 2;  // grayscale + alpha
+            case 6: return 4;  // RGBA
+            default: return 0; // palette or invalid
+        }
+    }
+
+    int colorTypeFor(const int channels) {
+        static constexpr int types[] = { 0, 4, 2, 6 };
+        return types[channels - 1];
+    }
+
+    // Reads the signature and IHDR chunk, leaving the stream at the IHDR CRC
+    std::optional<Header> readHeader(std::istream& in) {
+        unsigned char buffer[8 + 8 + 13];
+        if (!in.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) return std::nullopt;
+        if (!std::equal(Signature.begin(), Signature.end(), buffer)) return std::nullopt;
+        if (readBE32(buffer + 8) != 13 || std::memcmp(buffer + 12, "IHDR", 4) != 0) return std::nullopt;
+
+        const unsigned char* data = buffer + 16;
+        return Header{ readBE32(data), readBE32(data + 4), data[8], data[9], data[10], data[11], data[12] };
+    }
+
+    bool streamable(const Header& header) {
+        return header.width > 0 && header.height > 0 && header.width <= INT_MAX && header.height <= INT_MAX
+               && header.bitDepth == 8 && channelsFor(header.colorType) != 0
+               && header.compression == 0 && header.filter == 0 && header.interlace == 0;
+    }
+
+    unsigned char paethPredictor(const int a, const int b, const int c) {
+        const int p = a + b - c;
+        const int pa = std::abs(p - a);
+        const int pb = std::abs(p - b);
+        const int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+        return static_cast<unsigned char>(pb <= pc ? b : c);
+    }
+
+    // Reverses `filter` in place; `prev` is the previous unfiltered row (zeros for the first)
+    void unfilterRow(const unsigned char filter, unsigned char* row, const unsigned char* prev,
+                     const size_t size, const size_t bpp) {
+        switch (filter) {
+            case None:
+                break;
+            case Sub:
+                for (size_t i = bpp; i < size; ++i) row[i] += row[i - bpp];
+                break;
+            case Up:
+                for (size_t i = 0; i < size; ++i) row[i] += prev[i];
+                break;
+            case Average:
+                for (size_t i = 0; i < bpp; ++i) row[i] += prev[i] >> 1;
+                for (size_t i = bpp; i < size; ++i) row[i] += (row[i - bpp] + prev[i]) >> 1;
+                break;
+            case Paeth:
+                for (size_t i = 0; i < bpp; ++i) row[i] += prev[i];
+                for (size_t i = bpp; i < size; ++i) row[i] += paethPredictor(row[i - bpp], prev[i], prev[i - bpp]);
+                break;
+            default:
+                throw std::runtime_error("Corrupt PNG image data: unknown filter " + std::to_string(filter));
+        }
+    }
+
+    void filterRow(const unsigned char filter, const unsigned char* row, const unsigned char* prev,
+                   unsigned char* out, const size_t size, const size_t bpp) {
+        const size_t head = std::min(bpp, size);
+        switch (filter) {
+            case None:
+                std::memcpy(out, row, size);
+                break;
+            case Sub:
+                std::memcpy(out, row, head);
+                for (size_t i = bpp; i < size; ++i) out[i] = row[i] - row[i - bpp];
+                break;
+            case Up:
+                for (size_t i = 0; i < size; ++i) out[i] = row[i] - prev[i];
+                break;
+            case Average:
+                for (size_t i = 0; i < head; ++i) out[i] = row[i] - (prev[i] >> 1);
+                for (size_t i = bpp; i < size; ++i) out[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+                break;
+            case Paeth:
+                for (size_t i = 0; i < head; ++i) out[i] = row[i] - prev[i];
+                for (size_t i = bpp; i < size; ++i) out[i] = row[i] - paethPredictor(row[i - bpp], prev[i], prev[i - bpp]);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Drops alpha and widens grayscale, as stbi_load(..., 3) does
+    void convertRow(const unsigned char* src, const int from, unsigned char* dst, const int to, const size_t pixels) {
+        if (from == to) {
+            std::memcpy(dst, src, pixels * to);
+            return;
+        }
+        for (size_t i = 0; i < pixels; ++i, src += from, dst += 3) {
+            if (from <= 2) {
+                dst[0] = dst[1] = dst[2] = src[0];
+            } else {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+        }
+    }
+}
+
+// ---- PngReader ----
+
+PngReader::PngReader(const std::filesystem::path& path, const int desiredChannels)
+    : file(path, std::ios::binary), stream(std::make_unique<z_stream_s>()), input(IoBufferSize) {
+    if (!file) {
+        throw std::runtime_error("Error: could not open image: " + path.string());
+    }
+
+    const auto header = readHeader(file);
+    if (!header || !streamable(*header)) {
+        throw std::runtime_error("Unsupported PNG for streaming: " + path.string());
+    }
+
+    width_ = static_cast<int>(header->width);
+    height_ = static_cast<int>(header->height);
+    fileChannels = channelsFor(header->colorType);
+    if (desiredChannels != 0 && desiredChannels != 3 && desiredChannels != fileChannels) {
+        throw std::invalid_argument("PNG rows can only be converted to RGB");
+    }
+    channels_ = desiredChannels != 0 ? desiredChannels : fileChannels;
+
+    const size_t rawBytes = static_cast<size_t>(width_) * fileChannels;
+    current.assign(rawBytes + 1, 0);
+    previous.assign(rawBytes + 1, 0);
+
+    if (inflateInit(stream.get()) != Z_OK) {
+        throw std::runtime_error("Failed to initialise PNG decoder");
+    }
+}
+
+PngReader::~PngReader() {
+    inflateEnd(stream.get());
+}
+
+bool PngReader::supports(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    const auto header = readHeader(in);
+    return header && streamable(*header);
+}
+
+void PngReader::refill() {
+    while (chunkRemaining == 0) {
+        // CRC of the current chunk, then length and type of the next; CRCs are not checked, as in stb_image
+        unsigned char buffer[12];
+        if (!file.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) {
+            throw std::runtime_error("Truncated PNG file");
+        }
+        const uint32_t length = readBE32(buffer + 4);
+        if (std::memcmp(buffer + 8, "IDAT", 4) == 0) {
+            chunkRemaining = length;
+            inData = true;
+        } else if (inData || std::memcmp(buffer + 8, "IEND", 4) == 0) {
+            throw std::runtime_error("Truncated PNG image data");
+        } else {
+            file.seekg(length, std::ios::cur);
+        }
+    }
+
+    const size_t size = std::min<size_t>(chunkRemaining, input.size());
+    if (!file.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Truncated PNG file");
+    }
+    chunkRemaining -= static_cast<uint32_t>(size);
+    stream->next_in = input.data();
+    stream->avail_in = static_cast<uInt>(size);
+}
+
+bool PngReader::readRow(const std::span<unsigned char> row) {
+    if (rowsRead_ == height_) return false;
+    if (row.size() < rowBytes()) {
+        throw std::invalid_argument("PNG row buffer too small");
+    }
+
+    size_t filled = 0;
+    while (filled < current.size()) {
+        stream->next_out = current.data() + filled;
+        stream->avail_out = static_cast<uInt>(std::min<size_t>(current.size() - filled, UINT_MAX));
+        const int status = inflate(stream.get(), Z_NO_FLUSH);
+        filled = stream->next_out - current.data();
+
+        if (status == Z_STREAM_END) {
+            if (filled < current.size()) throw std::runtime_error("Truncated PNG image data");
+            break;
+        }
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            throw std::runtime_error("Corrupt PNG image data");
+        }
+        if (filled < current.size() && stream->avail_in == 0) {
+            refill();
+        }
+    }
+
+    const size_t rawBytes = current.size() - 1;
+    unfilterRow(current[0], current.data() + 1, previous.data() + 1, rawBytes, fileChannels);
+    convertRow(current.data() + 1, fileChannels, row.data(), channels_, width_);
+    std::swap(current, previous);
+    ++rowsRead_;
+    return true;
+}
+
+// ---- PngWriter ----
+
+PngEncoding::Level PngEncoding::parseLevel(const std::string& name) {
+    if (name == "store") return Level::Store;
+    if (name == "fast") return Level::Fast;
+    if (name == "default") return Level::Default;
+    if (name == "best") return Level::Best;
+    throw std::runtime_error("Unknown PNG level: " + name + " (expected store, fast, default or best)");
+}
+
+PngEncoding::Filter PngEncoding::parseFilter(const std::string& name) {
+    if (name == "none") return Filter::None;
+    if (name == "sub") return Filter::Sub;
+    if (name == "up") return Filter::Up;
+    if (name == "average") return Filter::Average;
+    if (name == "paeth") return Filter::Paeth;
+    if (name == "adaptive") return Filter::Adaptive;
+    throw std::runtime_error("Unknown PNG filter: " + name + " (expected none, sub, up, average, paeth or adaptive)");
+}
+
+namespace {
+    int zlibLevel(const PngEncoding::Level level) {
+        switch (level) {
+            case PngEncoding::Level::Store: return 0;
+            case PngEncoding::Level::Fast: return 1;
+            case PngEncoding::Level::Default: return 6;
+            case PngEncoding::Level::Best: return 9;
+        }
+        return Z_DEFAULT_COMPRESSION;
+    }
+
+    // zlib stream header for a 32 KiB window; the second byte carries the level hint and check bits
+    std::array<unsigned char, 2> zlibHeader(const int level) {
+        if (level <= 1) return { 0x78, 0x01 };
+        if (level <= 5) return { 0x78, 0x5E };
+        if (level == 6) return { 0x78, 0x9C };
+        return { 0x78, 0xDA };
+    }
+
+    // Raw-deflates `data` as a piece of a larger stream: primed with `dictionary`, and ended on a
+    // byte boundary with a sync flush unless it is the final piece.
+    std::vector<unsigned char> deflateBlock(const std::span<const unsigned char> data,
+                                            const std::span<const unsigned char> dictionary,
+                                            const int level, const int strategy, const bool last) {
+        z_stream stream{};
+        if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy) != Z_OK) {
+            throw std::runtime_error("Failed to initialise PNG encoder");
+        }
+        if (!dictionary.empty()) {
+            deflateSetDictionary(&stream, dictionary.data(), static_cast<uInt>(dictionary.size()));
+        }
+
+        std::vector<unsigned char> out(deflateBound(&stream, data.size()) + 16);
+        stream.next_in = const_cast<unsigned char*>(data.data());
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+
+        const int status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        out.resize(out.size() - stream.avail_out);
+        deflateEnd(&stream);
+
+        if (status != (last ? Z_STREAM_END : Z_OK) || stream.avail_in != 0) {
+            throw std::runtime_error("PNG compression failed");
+        }
+        return out;
+    }
+}
+
+PngWriter::PngWriter(const std::filesystem::path& path, const int width, const int height, const int channels,
+                     const PngEncoding encoding)
+    : file(path, std::ios::binary), encoding(encoding), output(IoBufferSize),
+      width_(width), height_(height), channels_(channels), adler(adler32(0L, nullptr, 0)) {
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        throw std::invalid_argument("Invalid PNG dimensions");
+    }
+    if (!file) {
+        throw std::runtime_error("Error: could not write image to " + path.string());
+    }
+    if (this->encoding.filter == PngEncoding::Filter::Adaptive && this->encoding.level == PngEncoding::Level::Store) {
+        this->encoding.filter = PngEncoding::Filter::None;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    previous.assign(rowBytes, 0);
+    candidates.assign(5, std::vector<unsigned char>(rowBytes + 1));
+
+    // Enough blocks to keep every thread busy, each at least one row
+    pendingLimit = std::max(DeflateBlockSize, rowBytes + 1) * ThreadPool::instance().threadCount();
+    pending.reserve(pendingLimit + rowBytes + 1);
+
+    file.write(reinterpret_cast<const char*>(Signature.data()), Signature.size());
+
+    unsigned char header[13];
+    writeBE32(header, static_cast<uint32_t>(width));
+    writeBE32(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8;
+    header[9] = static_cast<unsigned char>(colorTypeFor(channels));
+    header[10] = header[11] = header[12] = 0;
+    writeChunk("IHDR", header);
+
+    emit(zlibHeader(zlibLevel(this->encoding.level)));
+}
+
+void PngWriter::writeRow(const std::span<const unsigned char> row) {
+    const size_t rowBytes = previous.size();
+    if (finished || rowsWritten == height_) {
+        throw std::runtime_error("PNG writer received more rows than the image height");
+    }
+    if (row.size() < rowBytes) {
+        throw std::invalid_argument("PNG row too short");
+    }
+
+    size_t best = 0;
+    if (encoding.filter != PngEncoding::Filter::Adaptive) {
+        best = static_cast<size_t>(encoding.filter);
+        candidates[best][0] = static_cast<unsigned char>(best);
+        filterRow(candidates[best][0], row.data(), previous.data(), candidates[best].data() + 1, rowBytes, channels_);
+    } else {
+        uint64_t bestScore = UINT64_MAX;
+        for (size_t filter = None; filter <= Paeth; ++filter) {
+            auto& line = candidates[filter];
+            line[0] = static_cast<unsigned char>(filter);
+            filterRow(line[0], row.data(), previous.data(), line.data() + 1, rowBytes, channels_);
+
+            uint64_t score = 0;
+            for (size_t i = 1; i <= rowBytes; ++i) {
+                score += std::abs(static_cast<signed char>(line[i]));
+            }
+            if (score < bestScore) {
+                bestScore = score;
+                best = filter;
+            }
+        }
+    }
+
+    pending.insert(pending.end(), candidates[best].begin(), candidates[best].end());
+    std::memcpy(previous.data(), row.data(), rowBytes);
+    ++rowsWritten;
+
+    if (pending.size() >= pendingLimit) {
+        compressPending(false);
+    }
+}
+
+void PngWriter::finish() {
+    if (finished) return;
+    if (rowsWritten != height_) {
+        throw std::runtime_error("PNG writer finished after " + std::to_string(rowsWritten) + " of "
+                                 + std::to_string(height_) + " rows");
+    }
+
+    compressPending(true);
+
+    unsigned char trailer[4];
+    writeBE32(trailer, static_cast<uint32_t>(adler));
+    emit(trailer);
+
+    if (outputUsed > 0) {
+        writeChunk("IDAT", std::span(output).first(outputUsed));
+        outputUsed = 0;
+    }
+    writeChunk("IEND", {});
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Failed to write PNG data");
+    }
+    finished = true;
+}
+
+void PngWriter::compressPending(const bool last) {
+    const size_t blocks = std::max<size_t>(1, (pending.size() + DeflateBlockSize - 1) / DeflateBlockSize);
+    const int level = zlibLevel(encoding.level);
+    const int strategy = encoding.filter == PngEncoding::Filter::None ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+    std::vector<std::vector<unsigned char>> compressed(blocks);
+    std::vector<uLong> checksums(blocks);
+
+    ThreadPool::instance().parallelFor(blocks, 1, [&](const size_t begin, const size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            const size_t start = b * DeflateBlockSize;
+            const std::span<const unsigned char> data =
+                std::span(pending).subspan(start, std::min(DeflateBlockSize, pending.size() - start));
+
+            // Each block is primed with the bytes just before it, so splitting costs almost no ratio
+            const std::span<const unsigned char> dictionary = b == 0
+                ? std::span<const unsigned char>(window)
+                : std::span(pending).subspan(start - DeflateWindow, DeflateWindow);
+
+            compressed[b] = deflateBlock(data, dictionary, level, strategy, last && b + 1 == blocks);
+            checksums[b] = data.empty() ? adler32(0L, nullptr, 0)
+                                        : adler32(adler32(0L, nullptr, 0), data.data(), static_cast<uInt>(data.size()));
+        }
+    });
+
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t start = b * DeflateBlockSize;
+        const size_t length = std::min(DeflateBlockSize, pending.size() - std::min(start, pending.size()));
+        adler = adler32_combine(adler, checksums[b], static_cast<z_off_t>(length));
+        emit(compressed[b]);
+    }
+
+    const size_t keep = std::min(DeflateWindow, pending.size());
+    if (keep == DeflateWindow) {
+        window.assign(pending.end() - static_cast<std::ptrdiff_t>(keep), pending.end());
+    } else {
+        window.insert(window.end(), pending.begin(), pending.end());
+        if (window.size() > DeflateWindow) {
+            window.erase(window.begin(), window.end() - static_cast<std::ptrdiff_t>(DeflateWindow));
+        }
+    }
+    pending.clear();
+}
+
+void PngWriter::emit(std::span<const unsigned char> data) {
+    while (!data.empty()) {
+        const size_t n = std::min(data.size(), output.size() - outputUsed);
+        std::memcpy(output.data() + outputUsed, data.data(), n);
+        outputUsed += n;
+        data = data.subspan(n);
+
+        if (outputUsed == output.size()) {
+            writeChunk("IDAT", output);
+            outputUsed = 0;
+        }
+    }
+}
+
+void PngWriter::writeChunk(const char* type, const std::span<const unsigned char> data) {
+    unsigned char header[8];
+    writeBE32(header, static_cast<uint32_t>(data.size()));
+    std::memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0L, header + 4, 4);
+    if (!data.empty()) {
+        crc = crc32(crc, data.data(), static_cast<uInt>(data.size()));
+    }
+    unsigned char trailer[4];
+    writeBE32(trailer, static_cast<uint32_t>(crc));
+
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    file.write(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+    if (!file) {
+        throw std::runtime_error("Failed to write PNG data");
+    }
+}
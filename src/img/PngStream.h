@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+struct z_stream_s;
+
+// Row-at-a-time PNG decoding on top of zlib, so an image never has to be held in memory
+// as a whole. Handles non-interlaced 8-bit grayscale, grayscale+alpha, RGB and RGBA
+// files; anything else (palettes, 16-bit, Adam7) is left to stb_image, see supports().
+class PngReader {
+public:
+    // desiredChannels 0 keeps the file's own layout; 3 converts to RGB like stbi_load(..., 3)
+    explicit PngReader(const std::filesystem::path& path, int desiredChannels = 0);
+    ~PngReader();
+
+    PngReader(const PngReader&) = delete;
+    PngReader& operator=(const PngReader&) = delete;
+
+    // Whether path is a PNG this reader can decode
+    static bool supports(const std::filesystem::path& path);
+
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int height() const { return height_; }
+    [[nodiscard]] int channels() const { return channels_; }
+    [[nodiscard]] size_t rowBytes() const { return static_cast<size_t>(width_) * channels_; }
+    [[nodiscard]] int rowsRead() const { return rowsRead_; }
+
+    // Decodes the next row into the first rowBytes() bytes of `row`.
+    // Returns false once every row has been read.
+    bool readRow(std::span<unsigned char> row);
+
+private:
+    void refill();
+
+    std::ifstream file;
+    std::unique_ptr<z_stream_s> stream;
+    std::vector<unsigned char> input;
+    uint32_t chunkRemaining = 0;
+    bool inData = false;
+
+    int width_ = 0;
+    int height_ = 0;
+    int fileChannels = 0;
+    int channels_ = 0;
+    int rowsRead_ = 0;
+
+    // Filter byte plus the unfiltered bytes of the current and the previous row
+    std::vector<unsigned char> current;
+    std::vector<unsigned char> previous;
+};
+
+// How PngWriter trades encoding time for file size
+struct PngEncoding {
+    // zlib levels 0, 1, 6 and 9. Ciphertext does not compress, so Store or Fast suit it.
+    enum class Level { Store, Fast, Default, Best };
+
+    // Fixed PNG row filter, or Adaptive to pick one per row. Stored output gains nothing
+    // from filtering, so Adaptive means None there.
+    enum class Filter { None, Sub, Up, Average, Paeth, Adaptive };
+
+    Level level = Level::Default;
+    Filter filter = Filter::Adaptive;
+
+    static Level parseLevel(const std::string& name);
+    static Filter parseFilter(const std::string& name);
+};
+
+// Row-at-a-time PNG encoding. Adaptive filtering gives each row the filter that minimises
+// the sum of its absolute filtered values, the same heuristic stb_image_write uses.
+// Filtered rows are collected into blocks that are deflated on the ThreadPool, each primed
+// with the 32 KiB before it, so the output is one ordinary zlib stream.
+class PngWriter {
+public:
+    PngWriter(const std::filesystem::path& path, int width, int height, int channels, PngEncoding encoding = {});
+
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    // Takes the first width * channels bytes of `row`
+    void writeRow(std::span<const unsigned char> row);
+
+    // Flushes the compressed data and writes the end marker; every row must have been written
+    void finish();
+
+private:
+    // Deflates the pending rows, ending the zlib stream when `last` is set
+    void compressPending(bool last);
+    void emit(std::span<const unsigned char> data);
+    void writeChunk(const char* type, std::span<const unsigned char> data);
+
+    std::ofstream file;
+    PngEncoding encoding;
+    std::vector<unsigned char> output;
+    size_t outputUsed = 0;
+
+    int width_;
+    int height_;
+    int channels_;
+    int rowsWritten = 0;
+    bool finished = false;
+
+    // Filtered rows not yet compressed, and the tail of the ones before them
+    std::vector<unsigned char> pending;
+    std::vector<unsigned char> window;
+    size_t pendingLimit;
+    unsigned long adler;
+
+    std::vector<unsigned char> previous;
+    // One candidate line (filter byte plus filtered row) per PNG filter type
+    std::vector<std::vector<unsigned char>> candidates;
+};
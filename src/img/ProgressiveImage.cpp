@@ -0,0 +1,37 @@
+#include "ProgressiveImage.h"
+#include <algorithm>
+
+#include "ImageLoader.h"
+
+ProgressiveImage::ProgressiveImage(const std::filesystem::path& path) {
+    if (!PngReader::supports(path)) {
+        img = ImageLoader::mapImage(path);
+        return;
+    }
+
+    reader = std::make_unique<PngReader>(path);
+    img.reshape(reader->width(), 0, reader->channels());
+    ImageLoader::loadMetadata(path, img);
+}
+
+const Image& ProgressiveImage::require(const size_t bytes) {
+    if (!reader) return img;
+
+    const size_t rowBytes = reader->rowBytes();
+    const size_t wanted = bytes == 0 ? reader->height() : (bytes + rowBytes - 1) / rowBytes;
+    const int rows = static_cast<int>(std::min<size_t>(wanted, reader->height()));
+
+    if (rows > img.height) {
+        const int decoded = img.height;
+        img.reshape(img.width, rows, img.channels);
+        const std::span<unsigned char> pixels = img.pixelView();
+        for (int y = decoded; y < rows; ++y) {
+            reader->readRow(pixels.subspan(y * rowBytes, rowBytes));
+        }
+    }
+
+    if (img.height == reader->height()) {
+        reader.reset();
+    }
+    return img;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "Image.h"
+#include "PngStream.h"
+
+// An image whose rows are decoded only when asked for. Readers that need just the start
+// of the pixel data (the LSB header and payload, for instance) call require() with the
+// byte count they need and never pay for the rest of a large file. Files PngReader cannot
+// stream are mapped where possible (see ImageLoader::mapImage) and loaded whole otherwise.
+class ProgressiveImage {
+public:
+    explicit ProgressiveImage(const std::filesystem::path& path);
+
+    // Decodes rows until at least `bytes` pixel bytes are available, or the whole image when 0
+    const Image& require(size_t bytes);
+
+    // The rows decoded so far; height grows as more are required
+    [[nodiscard]] const Image& image() const { return img; }
+
+    [[nodiscard]] bool complete() const { return !reader; }
+
+private:
+    std::unique_ptr<PngReader> reader;
+    Image img;
+};
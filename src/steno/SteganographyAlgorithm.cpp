@@ -0,0 +1,20 @@
+#include "SteganographyAlgorithm.h"
+
+#include "../img/ImageUtils.h"
+
+std::tuple<bool, size_t, size_t> SteganographyAlgorithm::canEmbedData(const Image& carrierImage, const Image& imageToHide,
+                                                                      const std::string& password, const SizeMode mode) const {
+    const std::vector<unsigned char> serialized = ImageUtils::serializeImage(imageToHide);
+    if (mode == SizeMode::UpperBound) {
+        return fitsPayload(carrierImage, StegoPayload::sizeUpperBound(serialized));
+    }
+    if (mode == SizeMode::Estimate) {
+        return fitsPayload(carrierImage, StegoPayload::sizeEstimate(serialized));
+    }
+    return canEmbedData(carrierImage, StegoPayload::Prepared(serialized, password));
+}
+
+std::tuple<bool, size_t, size_t> SteganographyAlgorithm::canEmbedData(const Image& carrierImage,
+                                                                      const StegoPayload::Prepared& payload) const {
+    return fitsPayload(carrierImage, payload.size());
+}
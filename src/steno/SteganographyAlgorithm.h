@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../img/Image.h"
+#include "StegoPayload.h"
+#include <span>
 #include <string>
 #include <tuple>
 
@@ -8,27 +10,58 @@ class SteganographyAlgorithm {
 public:
     virtual ~SteganographyAlgorithm() = default;
 
+    // resultImage may be the carrier itself; the payload is then written in place and only
+    // the pixels that carry it are touched. Returns false, leaving resultImage unchanged,
+    // when the payload does not fit.
     virtual bool hideData(const Image& carrierImage, const std::string& dataToHide,
                          Image& resultImage, const std::string& key = "") = 0;
 
     virtual bool hideImage(const Image& carrierImage, const Image& imageToHide,
                           Image& resultImage, const std::string& key = "") = 0;
 
+    // Embeds a payload sealed earlier, under the same contract as hideData
+    virtual bool hidePayload(const Image& carrierImage, const StegoPayload::Prepared& payload,
+                             Image& resultImage) = 0;
+
     virtual bool extractData(const Image& steganoImage, std::string& extractedData,
                             const std::string& key = "") = 0;
 
     virtual bool extractImage(const Image& steganoImage, Image& extractedImage,
                              const std::string& key = "") = 0;
 
+    // How many leading pixel bytes extraction reads, judged from the `leading` bytes already
+    // decoded; lets callers decode a large carrier only as far as needed. The answer may grow
+    // as more bytes become available. 0 means extraction needs the whole image.
+    [[nodiscard]] virtual size_t extractionExtent(std::span<const unsigned char> leading) const { return 0; }
+
     virtual std::string name() const = 0;
 
     virtual std::string description() const = 0;
 
     virtual size_t maxHiddenDataSize(const Image& carrierImage) const = 0;
 
-    virtual std::tuple<bool, size_t, size_t> canEmbedData(
+    // How canEmbedData sizes the payload
+    enum class SizeMode {
+        Exact,       // Seals it, compression and key derivation included
+        UpperBound,  // StegoPayload::sizeUpperBound; no key derivation, and the compressBound worst case for large images
+        Estimate     // StegoPayload::sizeEstimate; sampled, so "fits" is a guess for large images
+    };
+
+    // Capacity planning: whether the payload fits, the carrier bytes it takes, and the capacity
+    [[nodiscard]] std::tuple<bool, size_t, size_t> canEmbedData(
     const Image& carrierImage,
     const Image& imageToHide,
-    const std::string& password = ""
-        ) const = 0;
+    const std::string& password = "",
+    SizeMode mode = SizeMode::Exact
+        ) const;
+
+    // Exact, and free once the payload is prepared; hidePayload can then embed the same bytes
+    [[nodiscard]] std::tuple<bool, size_t, size_t> canEmbedData(
+    const Image& carrierImage,
+    const StegoPayload::Prepared& payload
+        ) const;
+
+protected:
+    // Capacity planning for a sealed payload of `sealedSize` bytes
+    [[nodiscard]] virtual std::tuple<bool, size_t, size_t> fitsPayload(const Image& carrierImage, size_t sealedSize) const = 0;
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "SteganographyRegistry.h"
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+
+#include "impl/lsb/LSBSteganography.h"
+#include "impl/pvd/PVDSteganography.h"
+
+namespace {
+    int parseIntParam(const std::vector<std::string>& params, const size_t index, const int fallback,
+                      const int min, const int max, const std::string& what) {
+        if (index >= params.size() || params[index].empty()) return fallback;
+
+        size_t used = 0;
+        int value = 0;
+        try {
+            value = std::stoi(params[index], &used);
+        } catch (...) {
+            used = 0;
+        }
+        if (used != params[index].size() || value < min || value > max) {
+            throw std::runtime_error("Invalid " + what + ": " + params[index] + " (expected "
+                                     + std::to_string(min) + "-" + std::to_string(max) + ")");
+        }
+        return value;
+    }
+}
+
+SteganographyRegistry SteganographyRegistry::withBuiltins() {
+    SteganographyRegistry registry;
+
+    registry.add("lsb", "lsb[:bits per channel, 1-4]", [](const std::vector<std::string>& params) {
+        return std::make_shared<LSBSteganography>(parseIntParam(params, 0, 3, 1, 4, "LSB bits per channel"));
+    });
+    registry.add("pvd", "pvd[:edge threshold]", [](const std::vector<std::string>& params) {
+        return std::make_shared<PVDSteganography>(
+            parseIntParam(params, 0, PVDSteganography::DefaultEdgeThreshold, 0, 1082, "PVD edge threshold"));
+    });
+
+    // Ordered from least to most visible; any LSB depth embeds far faster than PVD.
+    // PVD carries at most 5 bits per pixel pair, less than lsb:1, so it never fits where LSB does not.
+    registry.setAutoCandidates({ "lsb:1", "lsb:2", "lsb:3", "lsb:4" });
+    return registry;
+}
+
+void SteganographyRegistry::add(const std::string& name, std::string usage, Factory factory) {
+    entries[name] = Entry{ std::move(usage), std::move(factory) };
+}
+
+std::shared_ptr<SteganographyAlgorithm> SteganographyRegistry::create(const std::string& spec) const {
+    std::vector<std::string> tokens;
+    std::istringstream iss(spec);
+    std::string token;
+    while (std::getline(iss, token, ':')) {
+        tokens.push_back(token);
+    }
+
+    if (tokens.empty()) {
+        throw std::runtime_error("Empty steganography algorithm");
+    }
+
+    const auto it = entries.find(tokens[0]);
+    if (it == entries.end()) {
+        throw std::runtime_error("Steganography algorithm not found: " + tokens[0]);
+    }
+
+    return it->second.factory(std::vector(tokens.begin() + 1, tokens.end()));
+}
+
+std::vector<std::string> SteganographyRegistry::usages() const {
+    std::vector<std::string> result;
+    for (const auto& entry : entries | std::views::values) {
+        result.push_back(entry.usage);
+    }
+    return result;
+}
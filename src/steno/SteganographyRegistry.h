@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SteganographyAlgorithm.h"
+
+// Builds steganography algorithms from specs of the form "name[:param...]", e.g. "lsb:2"
+// or "pvd:80". The same spec has to be given for hiding and extracting, since parameters
+// such as bits per channel or the edge threshold decide where the payload bits live.
+class SteganographyRegistry {
+public:
+    using Factory = std::function<std::shared_ptr<SteganographyAlgorithm>(const std::vector<std::string>& params)>;
+
+    // Spec that tries the auto candidates in order
+    static constexpr auto AutoSpec = "auto";
+
+    // Registry with the built-in algorithms: lsb[:bits 1-4, default 3] and pvd[:edge threshold, default 100]
+    static SteganographyRegistry withBuiltins();
+
+    void add(const std::string& name, std::string usage, Factory factory);
+
+    // Specs tried, in order, for "auto"
+    void setAutoCandidates(std::vector<std::string> specs) { autoCandidates = std::move(specs); }
+    [[nodiscard]] const std::vector<std::string>& getAutoCandidates() const { return autoCandidates; }
+
+    // Throws on unknown names or invalid parameters
+    [[nodiscard]] std::shared_ptr<SteganographyAlgorithm> create(const std::string& spec) const;
+
+    // "name[:params]" usage strings for help texts
+    [[nodiscard]] std::vector<std::string> usages() const;
+
+private:
+    struct Entry {
+        std::string usage;
+        Factory factory;
+    };
+
+    std::map<std::string, Entry> entries;
+    std::vector<std::string> autoCandidates;
+};
@@ -0,0 +1,185 @@
+#include "StegoPayload.h"
+#include <zlib.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+#include "../util/aes/AES256Encryptor.h"
+
+namespace StegoPayload {
+
+    namespace {
+        constexpr std::array<unsigned char, 4> FrameMagic = { 'H', 'N', 'S', 'z' };
+        constexpr size_t FrameHeaderSize = FrameMagic.size() + 8;
+
+        // Deflate cannot expand data by more than this factor, which bounds any claimed length
+        constexpr size_t MaxInflateRatio = 1032;
+
+        // Inputs up to SampleCount * SampleSize are deflated in full; sizeEstimate samples
+        // SampleCount blocks of SampleSize from larger ones
+        constexpr size_t SampleSize = 64 * 1024;
+        constexpr size_t SampleCount = 8;
+
+        static_assert(PrefixSize == KeyDerivation::EncodedSize + 32);
+
+        // Applies the CTR keystream from byte `offset` of the stream onwards, which need not
+        // fall on a block boundary
+        void encryptAt(const AES256Encryptor& aes, const std::vector<unsigned char>& iv, size_t offset,
+                       std::span<unsigned char> data) {
+            if (const size_t skip = offset % 16; skip != 0) {
+                std::array<unsigned char, 16> block{};
+                const size_t n = std::min(16 - skip, data.size());
+                std::memcpy(block.data() + skip, data.data(), n);
+                aes.transform(block, block, AES256Encryptor::counterAt(iv, offset / 16));
+                std::memcpy(data.data(), block.data() + skip, n);
+                data = data.subspan(n);
+                offset += n;
+            }
+            if (!data.empty()) {
+                aes.transform(data, data, AES256Encryptor::counterAt(iv, offset / 16));
+            }
+        }
+
+        size_t deflatedSize(const std::span<const unsigned char> data) {
+            ZLIBCompression::Deflater deflater(data);
+            std::vector<unsigned char> sink(ChunkSize);
+            size_t size = 0;
+            while (const size_t n = deflater.read(sink)) {
+                size += n;
+            }
+            return size;
+        }
+
+        // Legacy frames do not say how large they inflate; grow the buffer until it fits
+        bool inflateUnsized(const std::span<const unsigned char> compressed, std::string& data) {
+            const size_t maxSize = compressed.size() * MaxInflateRatio;
+            int status = Z_BUF_ERROR;
+            for (size_t capacity = std::min<size_t>(maxSize, std::max<size_t>(compressed.size() * 4, 4096));
+                 status == Z_BUF_ERROR; capacity = std::min(capacity * 2, maxSize)) {
+                data.resize(capacity);
+                uLongf size = capacity;
+                status = uncompress(reinterpret_cast<Bytef*>(data.data()), &size, compressed.data(), compressed.size());
+                data.resize(size);
+                if (status == Z_BUF_ERROR && capacity == maxSize) return false;
+            }
+            return status == Z_OK;
+        }
+    }
+
+    Sealer::Sealer(const std::span<const unsigned char> data, const std::string& password)
+        : aes(std::make_unique<AES256Encryptor>(AES256Encryptor::prepareKey(password))), iv(16), input(data), deflater(data) {
+        if (!RAND_bytes(iv.data(), 16)) {
+            throw std::runtime_error("Failed to generate random IV");
+        }
+
+        head = KeyDerivation::encode(aes->kdfParams());
+        head.insert(head.end(), aes->salt().begin(), aes->salt().end());
+        head.insert(head.end(), iv.begin(), iv.end());
+        head.insert(head.end(), FrameMagic.begin(), FrameMagic.end());
+        const uint64_t length = data.size();
+        for (int i = 0; i < 8; ++i) {
+            head.push_back(static_cast<unsigned char>(length >> (i * 8)));
+        }
+    }
+
+    Sealer::~Sealer() = default;
+
+    size_t Sealer::maxSize() const {
+        return PrefixSize + FrameHeaderSize + deflater.maxOutputSize();
+    }
+
+    size_t Sealer::exactSize() const {
+        return PrefixSize + FrameHeaderSize + deflatedSize(input);
+    }
+
+    size_t Sealer::read(const std::span<unsigned char> out) {
+        const size_t start = emitted;
+        size_t written = std::min(out.size(), head.size() - headUsed);
+        std::memcpy(out.data(), head.data() + headUsed, written);
+        headUsed += written;
+        written += deflater.read(out.subspan(written));
+        emitted += written;
+
+        // Everything past the prefix belongs to the frame and is encrypted in place
+        const size_t frameBegin = std::max(start, PrefixSize);
+        if (emitted > frameBegin) {
+            encryptAt(*aes, iv, frameBegin - PrefixSize, out.subspan(frameBegin - start, emitted - frameBegin));
+        }
+        return written;
+    }
+
+    std::vector<unsigned char> seal(const std::span<const unsigned char> data, const std::string& password) {
+        Sealer sealer(data, password);
+        std::vector<unsigned char> payload(sealer.maxSize());
+        size_t used = 0;
+        while (const size_t n = sealer.read(std::span(payload).subspan(used))) {
+            used += n;
+        }
+        payload.resize(used);
+        return payload;
+    }
+
+    size_t sizeUpperBound(const std::span<const unsigned char> data) {
+        constexpr size_t overhead = PrefixSize + FrameHeaderSize;
+        if (data.size() <= SampleCount * SampleSize) {
+            return overhead + deflatedSize(data);
+        }
+        return overhead + ZLIBCompression::Deflater(data).maxOutputSize();
+    }
+
+    size_t sizeEstimate(const std::span<const unsigned char> data) {
+        constexpr size_t overhead = PrefixSize + FrameHeaderSize;
+        if (data.size() <= SampleCount * SampleSize) {
+            return overhead + deflatedSize(data);
+        }
+
+        size_t worstSample = 0;
+        for (size_t i = 0; i < SampleCount; ++i) {
+            const size_t offset = i * (data.size() - SampleSize) / (SampleCount - 1);
+            worstSample = std::max(worstSample, deflatedSize(data.subspan(offset, SampleSize)));
+        }
+        const size_t blocks = (data.size() + SampleSize - 1) / SampleSize;
+        return overhead + std::min(ZLIBCompression::Deflater(data).maxOutputSize(), blocks * worstSample);
+    }
+
+    bool open(const std::span<const unsigned char> payload, const std::string& password, std::string& data) {
+        // Payloads written before the KDF was configurable start directly with the salt
+        std::optional<KeyDerivation::Params> params;
+        try {
+            params = KeyDerivation::decode(payload);
+        } catch (...) {
+            return false;
+        }
+        const size_t offset = params ? KeyDerivation::EncodedSize : 0;
+
+        if (payload.size() <= offset + 32) return false;
+
+        const std::vector salt(payload.begin() + offset, payload.begin() + offset + 16);
+        const std::vector iv(payload.begin() + offset + 16, payload.begin() + offset + 32);
+        const std::span<const unsigned char> encrypted = payload.subspan(offset + 32);
+
+        const AES256Encryptor aes(password, salt, params.value_or(KeyDerivation::legacyParams()));
+        std::vector<unsigned char> frame(encrypted.size());
+        aes.transform(encrypted, frame, iv);
+
+        if (frame.size() < FrameHeaderSize || !std::equal(FrameMagic.begin(), FrameMagic.end(), frame.begin())) {
+            return inflateUnsized(frame, data);
+        }
+
+        uint64_t length = 0;
+        for (int i = 0; i < 8; ++i) {
+            length |= static_cast<uint64_t>(frame[FrameMagic.size() + i]) << (i * 8);
+        }
+        const std::span<const unsigned char> compressed = std::span(frame).subspan(FrameHeaderSize);
+        if (length > compressed.size() * MaxInflateRatio) return false;
+
+        data.resize(length);
+        uLongf size = length;
+        return uncompress(reinterpret_cast<Bytef*>(data.data()), &size, compressed.data(), compressed.size()) == Z_OK &&
+               size == length;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../util/zlib/ZLibCompression.h"
+
+class AES256Encryptor;
+
+// The encrypted, compressed form a secret takes inside a carrier, shared by the embedding
+// algorithms (each adds its own size field in front):
+//
+//   KDF parameters | salt (16) | IV (16) | AES-256-CTR(frame)
+//   frame = "HNSz" | u64 uncompressed length (little-endian) | zlib stream
+//
+// Storing the length lets extraction inflate into an exactly sized buffer. Payloads written
+// before it was stored hold the bare zlib stream, and the oldest ones start directly with the
+// salt; both still open.
+namespace StegoPayload {
+    // Bytes seal() adds in front of the encrypted frame
+    constexpr size_t PrefixSize = 16 + 16 + 16;
+
+    // Sealed bytes embedders take from a Sealer per call
+    constexpr size_t ChunkSize = 64 * 1024;
+
+    // Produces a sealed payload a chunk at a time (deflate, then AES-CTR at the chunk's
+    // offset), so neither the compressed nor the encrypted form is ever held in full.
+    class Sealer {
+    public:
+        Sealer(std::span<const unsigned char> data, const std::string& password);
+        ~Sealer();
+
+        // Upper bound on the sealed size, known before anything is compressed
+        [[nodiscard]] size_t maxSize() const;
+
+        // Exact sealed size. Costs a deflate pass over the input that keeps only a chunk of
+        // output at a time, so callers ask only when maxSize() is not good enough.
+        [[nodiscard]] size_t exactSize() const;
+
+        // Fills as much of `out` as possible; returns the bytes written, 0 once everything is out
+        size_t read(std::span<unsigned char> out);
+
+    private:
+        std::unique_ptr<AES256Encryptor> aes;
+        std::vector<unsigned char> iv;
+        std::span<const unsigned char> input;
+        ZLIBCompression::Deflater deflater;
+
+        // Plain prefix followed by the frame header, emitted before the deflate output
+        std::vector<unsigned char> head;
+        size_t headUsed = 0;
+        // Bytes handed out so far
+        size_t emitted = 0;
+    };
+
+    [[nodiscard]] std::vector<unsigned char> seal(std::span<const unsigned char> data, const std::string& password);
+
+    // A secret sealed once up front, so its exact size can be checked against any number of
+    // carriers and algorithms without repeating the compression and key derivation, and the
+    // same bytes embedded by whichever one takes it.
+    class Prepared {
+    public:
+        Prepared(std::span<const unsigned char> data, const std::string& password) : sealed(seal(data, password)) {}
+
+        [[nodiscard]] size_t size() const { return sealed.size(); }
+        [[nodiscard]] std::span<const unsigned char> bytes() const { return sealed; }
+
+    private:
+        std::vector<unsigned char> sealed;
+    };
+
+    // Bound on the sealed size that needs no password or key derivation. Small inputs are
+    // deflated in full, which gives the exact size; larger ones get the compressBound worst
+    // case, which holds whatever the data looks like.
+    [[nodiscard]] size_t sizeUpperBound(std::span<const unsigned char> data);
+
+    // Cheaper guess at the sealed size. Small inputs are deflated in full, as above; larger
+    // ones scale the worst ratio among evenly spaced samples, capped by sizeUpperBound. Data
+    // that compresses much better at the samples than between them is undercounted, so a
+    // payload the estimate says fits may still not.
+    [[nodiscard]] size_t sizeEstimate(std::span<const unsigned char> data);
+
+    // Returns false if the payload is malformed or the password is wrong
+    [[nodiscard]] bool open(std::span<const unsigned char> payload, const std::string& password, std::string& data);
+}
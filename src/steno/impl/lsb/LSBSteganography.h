@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 #include <string>
 #include <vector>
 
@@ -17,15 +18,13 @@ public:
 
     bool hideImage(const Image &carrierImage, const Image &imageToHide, Image &resultImage, const std::string &key) override;
 
+    bool hidePayload(const Image& carrierImage, const StegoPayload::Prepared& payload, Image& resultImage) override;
+
     bool extractImage(const Image &steganoImage, Image &extractedImage, const std::string &key) override;
 
     [[nodiscard]] size_t maxHiddenDataSize(const Image& carrierImage) const override;
 
-    [[nodiscard]] std::tuple<bool, size_t, size_t> canEmbedData(
-    const Image& carrierImage,
-    const Image& imageToHide,
-    const std::string& password
-        ) const override;
+    [[nodiscard]] size_t extractionExtent(std::span<const unsigned char> leading) const override;
 
     [[nodiscard]] std::string name() const override { return "lsb"; }
 
@@ -33,15 +32,15 @@ public:
         return "Least Significant Bit (LSB) Steganography";
     }
 
+protected:
+    [[nodiscard]] std::tuple<bool, size_t, size_t> fitsPayload(const Image& carrierImage, size_t sealedSize) const override;
+
 private:
-    void embedByte(std::vector<unsigned char>& pixels, size_t& pixelIndex,
-                   unsigned char byte) const;
-    unsigned char extractByte(const std::vector<unsigned char>& pixels, size_t& pixelIndex) const;
-
-    void embedHeader(std::vector<unsigned char>& pixels, size_t& index,
-                     uint32_t dataSize) const;
-    void extractHeader(const std::vector<unsigned char>& pixels, size_t& index,
-                       uint32_t& dataSize) const;
+    // Carrier bytes taken by the 4-byte size header
+    [[nodiscard]] size_t headerCarrierBytes() const;
+
+    void embedHeader(std::span<unsigned char> pixels, uint32_t dataSize) const;
+    [[nodiscard]] uint32_t extractHeader(std::span<const unsigned char> pixels) const;
 
     int bitsPerChannel;
 };
@@ -1,15 +1,25 @@
 #include "PVDSteganography.h"
-#include <zlib.h>
-#include <openssl/rand.h>
 #include <cmath>
 #include <algorithm>
-#include <stdexcept>
-#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <utility>
 
+#include "../../StegoPayload.h"
 #include "../../../img/ImageUtils.h"
-#include "../../../util/aes/AES256Encryptor.h"
+#include "../../../util/simd/EdgeKernels.h"
+#include "../../../util/thread/ThreadPool.h"
 
 namespace {
+    // Size field, KDF parameters, salt and IV
+    constexpr size_t SizeFieldBytes = 4;
+    constexpr size_t HeaderSize = SizeFieldBytes + StegoPayload::PrefixSize;
+
+    // Pixels per edge-map task, rounded to whole rows
+    constexpr size_t RowGrainPixels = 64 * 1024;
+
     void embedLSB(unsigned char& byte, const unsigned char bit) {
         byte = (byte & ~1) | (bit & 1);
     }
@@ -18,11 +28,20 @@ namespace {
         return byte & 1;
     }
 
+    // The new difference stays in the same capacity range as the old one, so the extractor
+    // reads the same number of bits back. The larger value moves unless that would leave
+    // [0, 255], in which case the pair is shifted down instead of clamped.
     void embedBitsPVD(unsigned char& p1, unsigned char& p2, const unsigned char bits, const int bitCount) {
         const int d = std::abs(p1 - p2);
         const int newDiff = ((d >> bitCount) << bitCount) + bits;
-        if (p1 > p2) p1 = std::clamp<int>(p2 + newDiff, 0, 255);
-        else         p2 = std::clamp<int>(p1 + newDiff, 0, 255);
+        int low = std::min(p1, p2);
+        int high = low + newDiff;
+        if (high > 255) {
+            high = 255;
+            low = 255 - newDiff;
+        }
+        if (p1 >= p2) { p1 = high; p2 = low; }
+        else          { p1 = low; p2 = high; }
     }
 
     unsigned char extractBitsPVD(const unsigned char p1, const unsigned char p2, const int bitCount) {
@@ -32,28 +51,23 @@ namespace {
 }
 
 size_t PVDSteganography::maxHiddenDataSize(const Image& carrierImage) const {
-    const int width = carrierImage.getWidth();
-    const int height = carrierImage.getHeight();
-    return (width * height * 3) / 8;
-}
+    if (carrierImage.channels < 3) return 0;
 
-std::tuple<bool, size_t, size_t> PVDSteganography::canEmbedData(const Image& carrierImage, const Image& imageToHide, const std::string& password) const {
-    const auto serialized = ImageUtils::serializeImage(imageToHide);
-    const uLongf originalSize = serialized.size();
-    uLongf compSize = compressBound(originalSize);
-    std::vector<unsigned char> compressed(compSize);
-    if (compress(compressed.data(), &compSize, serialized.data(), originalSize) != Z_OK) return std::make_tuple(false,0,0);
-
-    compressed.resize(compSize);
-
-    std::vector<unsigned char> salt(16), iv(16);
-    if (!RAND_bytes(salt.data(), 16) || !RAND_bytes(iv.data(), 16)) return std::make_tuple(false,0,0);
+    // The capacity depends on the carrier's pixel pairs and edge map, so it takes the same
+    // pass embedding does
+    std::vector<unsigned char> edges(static_cast<size_t>(carrierImage.getWidth()) * carrierImage.getHeight());
+    applySobel(carrierImage, edges);
+    return payloadCapacity(rowBitOffsets(carrierImage, edges));
+}
 
-    const AES256Encryptor aes(password, salt);
-    const std::vector<unsigned char> encrypted = aes.encrypt(compressed, iv);
-    size_t payloadSize = 4 + 16 + 16 + encrypted.size();
+std::tuple<bool, size_t, size_t> PVDSteganography::fitsPayload(const Image& carrierImage, const size_t sealedSize) const {
+    const size_t capacity = maxHiddenDataSize(carrierImage);
+    return std::make_tuple(sealedSize <= capacity, sealedSize, capacity);
+}
 
-    return std::make_tuple(payloadSize <= maxHiddenDataSize(carrierImage), payloadSize, maxHiddenDataSize(carrierImage));
+size_t PVDSteganography::payloadCapacity(const std::vector<size_t>& offsets) {
+    const size_t bytes = offsets.back() / 8;
+    return bytes > SizeFieldBytes ? bytes - SizeFieldBytes : 0;
 }
 
 bool PVDSteganography::hideImage(const Image& carrierImage, const Image& imageToHide, Image& resultImage, const std::string& password) {
@@ -69,146 +83,181 @@ bool PVDSteganography::extractImage(const Image& steganoImage, Image& extractedI
 }
 
 bool PVDSteganography::hideData(const Image& carrierImage, const std::string& dataToHide, Image& resultImage, const std::string& password) {
-    const std::vector<unsigned char> data(dataToHide.begin(), dataToHide.end());
-    const uLongf originalSize = data.size();
-    uLongf compSize = compressBound(originalSize);
-    std::vector<unsigned char> compressed(compSize);
-
-    if (compress(compressed.data(), &compSize, data.data(), originalSize) != Z_OK) return false;
-    compressed.resize(compSize);
-
-    std::vector<unsigned char> salt(16), iv(16);
-    if (!RAND_bytes(salt.data(), 16) || !RAND_bytes(iv.data(), 16)) return false;
-
-    const AES256Encryptor aes(password, salt);
-    std::vector<unsigned char> encrypted = aes.encrypt(compressed, iv);
-
-    std::vector<unsigned char> payload;
-    uint32_t dataSize = encrypted.size();
-    payload.insert(payload.end(), reinterpret_cast<unsigned char*>(&dataSize), reinterpret_cast<unsigned char*>(&dataSize) + 4);
-    payload.insert(payload.end(), salt.begin(), salt.end());
-    payload.insert(payload.end(), iv.begin(), iv.end());
-    payload.insert(payload.end(), encrypted.begin(), encrypted.end());
-
-    resultImage = carrierImage;
-    std::vector<unsigned char> pixels = resultImage.getPixels();
-    const int width = carrierImage.getWidth();
-    const int height = carrierImage.getHeight();
-
-    std::vector<unsigned char> gray(height * width);
-    for (size_t i = 0; i < gray.size(); ++i) {
-        gray[i] = static_cast<unsigned char>(0.299f * static_cast<float>(pixels[i * 3 + 0]) + 0.587f * static_cast<float>(pixels[i * 3 + 1]) + 0.114f * static_cast<float>(pixels[i * 3 + 2]));
-    }
+    if (carrierImage.channels < 3) return false;
 
-    std::vector<unsigned char> edges(gray.size());
+    StegoPayload::Sealer sealer(std::span(reinterpret_cast<const unsigned char*>(dataToHide.data()), dataToHide.size()), password);
+
+    std::vector<unsigned char> edges(static_cast<size_t>(carrierImage.getWidth()) * carrierImage.getHeight());
     applySobel(carrierImage, edges);
+    const std::vector<size_t> offsets = rowBitOffsets(carrierImage, edges);
+    const size_t capacity = payloadCapacity(offsets);
 
-    size_t dataBitIndex = 0;
-    for (int y = 0; y < height && dataBitIndex < payload.size() * 8; ++y) {
-        for (int x = 0; x + 1 < width && dataBitIndex < payload.size() * 8; x += 2) {
-            const int i1 = (y * width + x) * 3;
-            const int i2 = (y * width + x + 1) * 3;
-            if (isTextured(edges, x, y, width)) {
-                for (int c = 0; c < 3 && dataBitIndex < payload.size() * 8; ++c) {
-                    const unsigned char bit = (payload[dataBitIndex / 8] >> (dataBitIndex % 8)) & 1;
-                    embedLSB(pixels[i1 + c], bit);
-                    ++dataBitIndex;
-                }
-            } else {
-                const int bits = getBitCapacity(std::abs(pixels[i1] - pixels[i2]));
-                unsigned char chunk = 0;
-                for (int b = 0; b < bits && dataBitIndex < payload.size() * 8; ++b) {
-                    chunk |= ((payload[dataBitIndex / 8] >> (dataBitIndex % 8)) & 1) << b;
-                    ++dataBitIndex;
-                }
-                embedBitsPVD(pixels[i1], pixels[i2], chunk, bits);
-            }
-        }
+    std::vector<unsigned char> chunk(StegoPayload::ChunkSize);
+
+    // Checked before anything is written, so a payload that does not fit leaves resultImage
+    // untouched. Only when the worst case might not fit is the exact size worked out first.
+    if (sealer.maxSize() > capacity && sealer.exactSize() > capacity) return false;
+
+    if (&resultImage != &carrierImage) resultImage = carrierImage;
+
+    // The size field goes in last, once the sealed size is known
+    size_t sealedSize = 0;
+    while (const size_t n = sealer.read(chunk)) {
+        embedBits(resultImage, edges, offsets, (SizeFieldBytes + sealedSize) * 8, std::span(chunk).first(n));
+        sealedSize += n;
     }
 
-    resultImage.setPixels(pixels);
+    embedSizeField(resultImage, edges, offsets, sealedSize);
     return true;
 }
 
-bool PVDSteganography::extractData(const Image& steganoImage, std::string& extractedData, const std::string& password) {
-    const auto pixels = steganoImage.getPixels();
-    const int width = steganoImage.getWidth();
-    const int height = steganoImage.getHeight();
+bool PVDSteganography::hidePayload(const Image& carrierImage, const StegoPayload::Prepared& payload, Image& resultImage) {
+    if (carrierImage.channels < 3) return false;
 
-    std::vector<unsigned char> gray(width * height);
-    for (size_t i = 0; i < gray.size(); ++i) {
-        gray[i] = static_cast<unsigned char>(0.299f * static_cast<float>(pixels[i * 3 + 0]) + 0.587f * static_cast<float>(pixels[i * 3 + 1]) + 0.114f * static_cast<float>(pixels[i * 3 + 2]));
+    std::vector<unsigned char> edges(static_cast<size_t>(carrierImage.getWidth()) * carrierImage.getHeight());
+    applySobel(carrierImage, edges);
+    const std::vector<size_t> offsets = rowBitOffsets(carrierImage, edges);
+    if (payload.size() > payloadCapacity(offsets)) return false;
+
+    if (&resultImage != &carrierImage) resultImage = carrierImage;
+    embedBits(resultImage, edges, offsets, SizeFieldBytes * 8, payload.bytes());
+    embedSizeField(resultImage, edges, offsets, payload.size());
+    return true;
+}
+
+void PVDSteganography::embedSizeField(Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                                      const size_t sealedSize) {
+    // The size field counts the encrypted bytes after the KDF parameters, salt and IV
+    const auto dataSize = static_cast<uint32_t>(sealedSize - StegoPayload::PrefixSize);
+    unsigned char sizeField[SizeFieldBytes];
+    for (size_t i = 0; i < SizeFieldBytes; ++i) {
+        sizeField[i] = static_cast<unsigned char>(dataSize >> (i * 8));
     }
+    embedBits(img, edges, offsets, 0, sizeField);
+}
+
+bool PVDSteganography::extractData(const Image& steganoImage, std::string& extractedData, const std::string& password) {
+    if (steganoImage.channels < 3) return false;
 
-    std::vector<unsigned char> edges(gray.size());
+    std::vector<unsigned char> edges(static_cast<size_t>(steganoImage.getWidth()) * steganoImage.getHeight());
     applySobel(steganoImage, edges);
+    const std::vector<size_t> offsets = rowBitOffsets(steganoImage, edges);
+    const size_t capacity = offsets.back() / 8;
+    if (capacity < HeaderSize) return false;
+
+    std::vector<unsigned char> extracted(HeaderSize);
+    extractBits(steganoImage, edges, offsets, 0, extracted);
+
+    const uint32_t dataSize = extracted[0] | extracted[1] << 8 | extracted[2] << 16 | static_cast<uint32_t>(extracted[3]) << 24;
+    if (dataSize > capacity - HeaderSize) return false;
+
+    extracted.resize(HeaderSize + dataSize);
+    extractBits(steganoImage, edges, offsets, HeaderSize * 8, std::span(extracted).subspan(HeaderSize));
 
-    std::vector<unsigned char> extracted;
-    unsigned char currentByte = 0;
-    int bitCount = 0;
-    size_t extractedSize = 0;
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x + 1 < width; x += 2) {
-            const int i1 = (y * width + x) * 3;
-            const int i2 = (y * width + x + 1) * 3;
-
-            if (isTextured(edges, x, y, width)) {
-                for (int c = 0; c < 3; ++c) {
-                    currentByte |= (extractLSB(pixels[i1 + c]) << bitCount++);
-                    if (bitCount == 8) {
-                        extracted.push_back(currentByte);
-                        if (extracted.size() == 4) {
-                            extractedSize = *reinterpret_cast<uint32_t*>(extracted.data());
+    return StegoPayload::open(std::span(extracted).subspan(SizeFieldBytes), password, extractedData);
+}
+
+void PVDSteganography::embedBits(Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                                 const size_t firstBit, const std::span<const unsigned char> bytes) {
+    const int width = img.getWidth();
+    const int channels = img.channels;
+    const std::span<unsigned char> pixels = img.pixelView();
+
+    const size_t endBit = firstBit + bytes.size() * 8;
+    auto bitAt = [&](const size_t bit) {
+        const size_t i = bit - firstBit;
+        return static_cast<unsigned char>((bytes[i / 8] >> (i % 8)) & 1);
+    };
+
+    // Rows own disjoint pixels, so each can be written independently from its bit offset
+    const auto [firstRow, endRow] = rowRange(offsets, firstBit, endBit);
+    const size_t rowGrain = std::max<size_t>(1, RowGrainPixels / width);
+    ThreadPool::instance().parallelFor(endRow - firstRow, rowGrain, [&](const size_t begin, const size_t end) {
+        for (size_t y = firstRow + begin; y < firstRow + end; ++y) {
+            size_t bit = offsets[y];
+            for (int x = 0; x + 1 < width && bit < endBit; x += 2) {
+                const size_t i1 = (y * width + x) * channels;
+                const size_t i2 = i1 + channels;
+                const bool textured = isTextured(edges, x, static_cast<int>(y), width);
+                const int slots = textured ? 3 : getBitCapacity(std::abs(pixels[i1] - pixels[i2]));
+
+                // A pair may straddle the range; only its bits inside it change
+                if (bit + slots > firstBit) {
+                    const int from = bit < firstBit ? static_cast<int>(firstBit - bit) : 0;
+                    const int to = static_cast<int>(std::min<size_t>(slots, endBit - bit));
+                    if (textured) {
+                        for (int c = from; c < to; ++c) {
+                            embedLSB(pixels[i1 + c], bitAt(bit + c));
                         }
-                        bitCount = 0;
-                        currentByte = 0;
-                        if (extractedSize && extracted.size() >= extractedSize + 36) goto done;
-                    }
-                }
-            } else {
-                const int bits = getBitCapacity(std::abs(pixels[i1] - pixels[i2]));
-                const unsigned char val = extractBitsPVD(pixels[i1], pixels[i2], bits);
-                for (int b = 0; b < bits; ++b) {
-                    currentByte |= ((val >> b) & 1) << bitCount++;
-                    if (bitCount == 8) {
-                        extracted.push_back(currentByte);
-                        if (extracted.size() == 4) {
-                            extractedSize = *reinterpret_cast<uint32_t*>(extracted.data());
+                    } else {
+                        unsigned char value = extractBitsPVD(pixels[i1], pixels[i2], slots);
+                        for (int b = from; b < to; ++b) {
+                            value = static_cast<unsigned char>((value & ~(1 << b)) | bitAt(bit + b) << b);
                         }
-                        bitCount = 0;
-                        currentByte = 0;
-                        if (extractedSize && extracted.size() >= extractedSize + 36) goto done;
+                        embedBitsPVD(pixels[i1], pixels[i2], value, slots);
                     }
                 }
+                bit += slots;
             }
         }
-    }
-
-    done:
-    if (extracted.size() < 36) return false;
-
-    const std::vector salt(extracted.begin() + 4, extracted.begin() + 20);
-    const std::vector iv(extracted.begin() + 20, extracted.begin() + 36);
-    const std::vector encrypted(extracted.begin() + 36, extracted.end());
-
-    const AES256Encryptor aes(password, salt);
-    std::vector<unsigned char> compressed;
-
-    try {
-        compressed = aes.decrypt(encrypted, iv);
-    } catch (...) {
-        return false;
-    }
-
-    uLongf decompressedSize = steganoImage.getWidth() * steganoImage.getHeight() * steganoImage.channels;
-    std::vector<unsigned char> decompressed(decompressedSize);
-    if (uncompress(decompressed.data(), &decompressedSize, compressed.data(), compressed.size()) != Z_OK)
-        return false;
+    });
+}
 
-    decompressed.resize(decompressedSize);
-    extractedData.assign(decompressed.begin(), decompressed.end());
-    return true;
+void PVDSteganography::extractBits(const Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                                   const size_t firstBit, const std::span<unsigned char> bytes) {
+    const int width = img.getWidth();
+    const int channels = img.channels;
+    const std::span<const unsigned char> pixels = img.pixelView();
+
+    const size_t endBit = firstBit + bytes.size() * 8;
+    std::fill(bytes.begin(), bytes.end(), 0);
+
+    const auto [firstRow, endRow] = rowRange(offsets, firstBit, endBit);
+    const size_t rowGrain = std::max<size_t>(1, RowGrainPixels / width);
+    ThreadPool::instance().parallelFor(endRow - firstRow, rowGrain, [&](const size_t begin, const size_t end) {
+        for (size_t y = firstRow + begin; y < firstRow + end; ++y) {
+            // Bits are gathered a byte at a time. A byte the row only partly covers is shared
+            // with the neighbouring row, so those are merged in atomically.
+            unsigned int current = 0;
+            int gathered = 0;
+            size_t byteIndex = 0;
+            auto flush = [&] {
+                if (gathered == 8) {
+                    bytes[byteIndex] = static_cast<unsigned char>(current);
+                } else if (gathered > 0) {
+                    std::atomic_ref(bytes[byteIndex]).fetch_or(static_cast<unsigned char>(current), std::memory_order_relaxed);
+                }
+                current = 0;
+                gathered = 0;
+            };
+            auto put = [&](const size_t bit, const unsigned int value) {
+                const size_t i = bit - firstBit;
+                if (gathered > 0 && i / 8 != byteIndex) flush();
+                byteIndex = i / 8;
+                current |= value << (i % 8);
+                ++gathered;
+            };
+
+            size_t bit = offsets[y];
+            for (int x = 0; x + 1 < width && bit < endBit; x += 2) {
+                const size_t i1 = (y * width + x) * channels;
+                const size_t i2 = i1 + channels;
+                const bool textured = isTextured(edges, x, static_cast<int>(y), width);
+                const int slots = textured ? 3 : getBitCapacity(std::abs(pixels[i1] - pixels[i2]));
+
+                if (bit + slots > firstBit) {
+                    const int from = bit < firstBit ? static_cast<int>(firstBit - bit) : 0;
+                    const int to = static_cast<int>(std::min<size_t>(slots, endBit - bit));
+                    const unsigned char value = textured ? 0 : extractBitsPVD(pixels[i1], pixels[i2], slots);
+                    for (int b = from; b < to; ++b) {
+                        put(bit + b, textured ? extractLSB(pixels[i1 + b]) : (value >> b) & 1);
+                    }
+                }
+                bit += slots;
+            }
+            flush();
+        }
+    });
 }
 
 int PVDSteganography::getBitCapacity(const int diff) {
@@ -230,29 +279,72 @@ int PVDSteganography::getMinDiffForBits(const int bits) {
     }
 }
 
-void PVDSteganography::applySobel(const Image& img, std::vector<unsigned char>& edges) {
+void PVDSteganography::applySobel(const Image& img, std::vector<unsigned char>& edges) const {
     const int width = img.getWidth();
     const int height = img.getHeight();
-    const std::vector<unsigned char>& pixels = img.getPixels();
-
-    for (int y = 1; y < height - 1; ++y) {
-        for (int x = 1; x < width - 1; ++x) {
-            int gx = 0, gy = 0;
-            for (int ky = -1; ky <= 1; ++ky) {
-                for (int kx = -1; kx <= 1; ++kx) {
-                    const int px = x + kx;
-                    const int py = y + ky;
-                    const int i = (py * width + px) * 3;
-                    const auto gray = static_cast<unsigned char>(
-                        0.299f * static_cast<float>(pixels[i]) + 0.587f * static_cast<float>(pixels[i + 1]) + 0.114f * static_cast<float>(pixels[i + 2]));
-                    gx += kx * gray;
-                    gy += ky * gray;
-                }
+    const int channels = img.channels;
+    if (width < 3 || height < 3) return;
+
+    const std::span<const unsigned char> pixels = img.pixelView();
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    const size_t rowGrain = std::max<size_t>(1, RowGrainPixels / width);
+
+    // Embedding rewrites red and the LSBs of green and blue, so the edge map is built from
+    // what survives it; otherwise extraction could not rebuild the map. Each luma value feeds
+    // nine gradients, so the plane is computed once up front.
+    std::vector<unsigned char> luma(static_cast<size_t>(width) * height);
+    ThreadPool::instance().parallelFor(height, rowGrain, [&](const size_t begin, const size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            EdgeKernels::luma(pixels.subspan(y * rowBytes, rowBytes), channels,
+                              std::span(luma).subspan(y * width, width));
+        }
+    });
+
+    // floor(sqrt(m)) > t exactly when m >= (t + 1)^2, so no square root is needed
+    const uint32_t minMagnitudeSquared = edgeThreshold < 0
+        ? 0
+        : static_cast<uint32_t>(std::min<uint64_t>((static_cast<uint64_t>(edgeThreshold) + 1) * (edgeThreshold + 1), UINT32_MAX));
+
+    const std::span<const unsigned char> plane = luma;
+    ThreadPool::instance().parallelFor(height - 2, rowGrain, [&](const size_t begin, const size_t end) {
+        for (size_t y = begin + 1; y < end + 1; ++y) {
+            EdgeKernels::edgeRow(plane.subspan((y - 1) * width, width), plane.subspan(y * width, width),
+                                 plane.subspan((y + 1) * width, width), minMagnitudeSquared,
+                                 std::span(edges).subspan(y * width, width));
+        }
+    });
+}
+
+std::vector<size_t> PVDSteganography::rowBitOffsets(const Image& img, const std::vector<unsigned char>& edges) {
+    const int width = img.getWidth();
+    const int height = img.getHeight();
+    const int channels = img.channels;
+    const std::span<const unsigned char> pixels = img.pixelView();
+
+    // Embedding keeps every pair in its capacity range, so the carrier's own pairs decide the
+    // capacity, and the stego image gives back the same offsets
+    std::vector<size_t> offsets(static_cast<size_t>(height) + 1, 0);
+    const size_t rowGrain = std::max<size_t>(1, RowGrainPixels / std::max(width, 1));
+    ThreadPool::instance().parallelFor(height, rowGrain, [&](const size_t begin, const size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            size_t bits = 0;
+            for (int x = 0; x + 1 < width; x += 2) {
+                const size_t i1 = (y * width + x) * channels;
+                const size_t i2 = i1 + channels;
+                bits += isTextured(edges, x, static_cast<int>(y), width) ? 3 : getBitCapacity(std::abs(pixels[i1] - pixels[i2]));
             }
-            const int mag = static_cast<int>(std::sqrt(gx * gx + gy * gy));
-            edges[y * width + x] = (mag > SobelThreshold) ? 255 : 0;
+            offsets[y + 1] = bits;
         }
-    }
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    return offsets;
+}
+
+std::pair<size_t, size_t> PVDSteganography::rowRange(const std::vector<size_t>& offsets, const size_t firstBit, const size_t endBit) {
+    // The last row starting at or before firstBit, through the last one starting before endBit
+    const auto first = std::upper_bound(offsets.begin(), offsets.end() - 1, firstBit) - 1;
+    const auto end = std::lower_bound(first, offsets.end() - 1, endBit);
+    return { static_cast<size_t>(first - offsets.begin()), static_cast<size_t>(end - offsets.begin()) };
 }
 
 bool PVDSteganography::isTextured(const std::vector<unsigned char>& edges, const int x, const int y, const int width) {
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 #include "../../../img/Image.h"
 #include "../../SteganographyAlgorithm.h"
 
 class PVDSteganography final : public SteganographyAlgorithm {
 public:
+    static constexpr int DefaultEdgeThreshold = 100;
+
+    // Pixels whose edge magnitude exceeds `edgeThreshold` count as textured and take plain
+    // LSB embedding; the rest carry bits in the red difference of each pixel pair.
+    explicit PVDSteganography(int edgeThreshold = DefaultEdgeThreshold) : edgeThreshold(edgeThreshold) {}
+
     [[nodiscard]] std::string name() const override { return "pvd"; }
 
     [[nodiscard]] std::string description() const override {
@@ -25,22 +33,43 @@ public:
     bool extractImage(const Image& steganoImage, Image& extractedImage,
                       const std::string& password ) override;
 
-    [[nodiscard]] std::tuple<bool, size_t, size_t> canEmbedData(
-    const Image& carrierImage,
-    const Image& imageToHide,
-    const std::string& password
-        ) const override;
+    bool hidePayload(const Image& carrierImage, const StegoPayload::Prepared& payload, Image& resultImage) override;
 
     [[nodiscard]] size_t maxHiddenDataSize(const Image& carrierImage) const override;
 
+protected:
+    [[nodiscard]] std::tuple<bool, size_t, size_t> fitsPayload(const Image& carrierImage, size_t sealedSize) const override;
+
 private:
     static int getBitCapacity(int diff);
 
     static int getMinDiffForBits(int bits);
 
-    static void applySobel(const Image& img, std::vector<unsigned char>& edges);
+    void applySobel(const Image& img, std::vector<unsigned char>& edges) const;
+
+    // Bit offset at which each row's payload bits start, with the total capacity appended
+    static std::vector<size_t> rowBitOffsets(const Image& img, const std::vector<unsigned char>& edges);
+
+    // Sealed payload bytes the carrier holds after the size field
+    static size_t payloadCapacity(const std::vector<size_t>& offsets);
+
+    // Rows holding bits [firstBit, endBit), as a half-open range
+    static std::pair<size_t, size_t> rowRange(const std::vector<size_t>& offsets, size_t firstBit, size_t endBit);
 
     static bool isTextured(const std::vector<unsigned char>& edges, int x, int y, int width);
 
-    static constexpr int SobelThreshold = 100;
+    // Writes `bytes` (least significant bit first) into the payload bits from firstBit on,
+    // one row per task. The caller has checked the capacity.
+    static void embedBits(Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                          size_t firstBit, std::span<const unsigned char> bytes);
+
+    // Writes the size field in front of `sealedSize` sealed bytes already embedded after it
+    static void embedSizeField(Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                               size_t sealedSize);
+
+    // Reads bytes.size() bytes back from the payload bits starting at firstBit
+    static void extractBits(const Image& img, const std::vector<unsigned char>& edges, const std::vector<size_t>& offsets,
+                            size_t firstBit, std::span<unsigned char> bytes);
+
+    int edgeThreshold;
 };
@@ -2,85 +2,143 @@
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <cstring>
 
-AES256Encryptor::AES256Encryptor(const std::string& password, const std::vector<unsigned char>& salt) {
-    if (salt.size() != 16) {
-        throw std::runtime_error("Salt must be 16 bytes");
-    }
+#include "../thread/ThreadPool.h"
+
+namespace {
+    struct CipherContextDeleter {
+        void operator()(EVP_CIPHER_CTX* ctx) const { EVP_CIPHER_CTX_free(ctx); }
+    };
+    using CipherContext = std::unique_ptr<EVP_CIPHER_CTX, CipherContextDeleter>;
+
+    // Cipher contexts that already hold the key schedule for recently used keys, one pool
+    // per thread. Keys are matched by identity, which works because they are shared through
+    // KeyDerivationCache; a context for a key that has since been released is freed (and
+    // its schedule wiped) on the thread's next lookup or when it is evicted.
+    class CipherContextPool {
+    public:
+        // Returns a context keyed for `key` and reset to start at `iv`. It stays valid until
+        // the next acquire() on the same thread.
+        EVP_CIPHER_CTX* acquire(const KeyDerivationCache::KeyPtr& key, const unsigned char* iv) {
+            std::erase_if(slots, [](const Slot& slot) { return slot.key.expired(); });
+
+            const auto it = std::ranges::find_if(slots, [&](const Slot& slot) {
+                return !slot.key.owner_before(key) && !key.owner_before(slot.key);
+            });
+
+            if (it != slots.end()) {
+                std::rotate(slots.begin(), it, it + 1);
+                // Only the IV changes, so the key schedule is kept
+                if (1 != EVP_EncryptInit_ex(slots.front().ctx.get(), nullptr, nullptr, nullptr, iv)) {
+                    slots.erase(slots.begin());
+                    throw std::runtime_error("EVP_EncryptInit_ex failed");
+                }
+                return slots.front().ctx.get();
+            }
 
-    key_.resize(32); // 256-bit key
+            CipherContext ctx(EVP_CIPHER_CTX_new());
+            if (!ctx) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
+            if (1 != EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ctr(), nullptr, key->key.data(), iv)) {
+                throw std::runtime_error("EVP_EncryptInit_ex failed");
+            }
 
-    // Derive key using PBKDF2 with SHA256
+            if (slots.size() >= Capacity) slots.pop_back();
+            slots.insert(slots.begin(), Slot{ key, std::move(ctx) });
+            return slots.front().ctx.get();
+        }
 
-    if (constexpr int iterations = 100000; !PKCS5_PBKDF2_HMAC(
-            password.c_str(),
-            static_cast<int>(password.size()),
-            salt.data(),
-            static_cast<int>(salt.size()),
-            iterations,
-            EVP_sha256(),
-            static_cast<int>(key_.size()),
-            key_.data())) {
-        throw std::runtime_error("Failed to derive key with PBKDF2");
-            }
-}
+    private:
+        struct Slot {
+            std::weak_ptr<const KeyDerivationCache::DerivedKey> key;
+            CipherContext ctx;
+        };
 
-std::vector<unsigned char> AES256Encryptor::encrypt(const std::vector<unsigned char>& plaintext, const std::vector<unsigned char>& iv) const {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
+        static constexpr size_t Capacity = 4;
+        std::vector<Slot> slots; // most recently used first
+    };
 
-    if (1 != EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), nullptr, key_.data(), iv.data())) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_EncryptInit_ex failed");
+    thread_local CipherContextPool contextPool;
+}
+
+AES256Encryptor::AES256Encryptor(const std::string& password, const std::vector<unsigned char>& salt,
+                                 const KeyDerivation::Params& params) {
+    if (salt.size() != 16) {
+        throw std::runtime_error("Salt must be 16 bytes");
     }
 
-    std::vector<unsigned char> ciphertext(plaintext.size() + EVP_CIPHER_block_size(EVP_aes_256_ctr()));
-    int len = 0;
+    // Reuses an earlier derivation of the same inputs when possible
+    key_ = KeyDerivationCache::instance().derive(password, salt, params, 32);
+}
 
-    if (1 != EVP_EncryptUpdate(ctx, ciphertext.data(), &len, plaintext.data(), static_cast<int>(plaintext.size()))) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_EncryptUpdate failed");
+AES256Encryptor::AES256Encryptor(KeyDerivationCache::KeyPtr key) : key_(std::move(key)) {
+    if (!key_ || key_->key.size() != 32) {
+        throw std::runtime_error("AES-256 requires a 32-byte key");
     }
-    int ciphertext_len = len;
+}
 
-    if (1 != EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len)) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_EncryptFinal_ex failed");
-    }
-    ciphertext_len += len;
+KeyDerivationCache::KeyPtr AES256Encryptor::prepareKey(const std::string& password, const KeyDerivation::Params& params) {
+    return KeyDerivationCache::instance().prepare(password, 16, params, 32);
+}
 
-    EVP_CIPHER_CTX_free(ctx);
-    ciphertext.resize(ciphertext_len);
+std::vector<unsigned char> AES256Encryptor::encrypt(const std::vector<unsigned char>& plaintext, const std::vector<unsigned char>& iv) const {
+    // CTR needs no padding, so the ciphertext is exactly as long as the plaintext
+    std::vector<unsigned char> ciphertext(plaintext.size());
+    transform(plaintext, ciphertext, iv);
     return ciphertext;
 }
 
 std::vector<unsigned char> AES256Encryptor::decrypt(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& iv) const {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
-
-    if (1 != EVP_DecryptInit_ex(ctx, EVP_aes_256_ctr(), nullptr, key_.data(), iv.data())) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptInit_ex failed");
-    }
-
     std::vector<unsigned char> plaintext(ciphertext.size());
-    int len = 0;
+    transform(ciphertext, plaintext, iv);
+    return plaintext;
+}
 
-    if (1 != EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext.data(), static_cast<int>(ciphertext.size()))) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptUpdate failed");
+std::vector<unsigned char> AES256Encryptor::counterAt(const std::vector<unsigned char>& iv, uint64_t blockIndex) {
+    // OpenSSL treats the whole 16-byte IV as one big-endian counter
+    std::vector<unsigned char> counter = iv;
+    for (int i = 15; i >= 0 && blockIndex != 0; --i) {
+        const uint64_t sum = counter[i] + (blockIndex & 0xFF);
+        counter[i] = static_cast<unsigned char>(sum);
+        blockIndex = (blockIndex >> 8) + (sum >> 8);
     }
-    int plaintext_len = len;
+    return counter;
+}
 
-    if (1 != EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len)) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptFinal_ex failed");
+void AES256Encryptor::transform(const std::span<const unsigned char> input, const std::span<unsigned char> output,
+                                const std::vector<unsigned char>& iv) const {
+    if (iv.size() != 16) {
+        throw std::runtime_error("IV must be 16 bytes");
+    }
+    if (output.size() < input.size()) {
+        throw std::runtime_error("Output buffer too small");
     }
-    plaintext_len += len;
 
-    EVP_CIPHER_CTX_free(ctx);
-    plaintext.resize(plaintext_len);
-    return plaintext;
+    // Each chunk starts on a block boundary, so its counter can be computed directly
+    // from the IV and the chunks can be processed independently.
+    ThreadPool::instance().parallelFor(input.size(), ParallelChunkSize, [&](const size_t begin, const size_t end) {
+        transformRange(input.subspan(begin, end - begin), output.data() + begin, counterAt(iv, begin / 16));
+    });
+}
+
+void AES256Encryptor::transformInPlace(const std::span<unsigned char> data, const std::vector<unsigned char>& iv) const {
+    transform(data, data, iv);
+}
+
+void AES256Encryptor::transformRange(const std::span<const unsigned char> input, unsigned char* output,
+                                     const std::vector<unsigned char>& counter) const {
+    EVP_CIPHER_CTX* ctx = contextPool.acquire(key_, counter.data());
+
+    // EVP lengths are int, so large ranges are fed through in slices
+    constexpr size_t maxSlice = 1u << 30;
+    for (size_t offset = 0; offset < input.size(); offset += maxSlice) {
+        const int sliceLen = static_cast<int>(std::min(maxSlice, input.size() - offset));
+        int len = 0;
+        if (1 != EVP_EncryptUpdate(ctx, output + offset, &len, input.data() + offset, sliceLen)) {
+            throw std::runtime_error("EVP_EncryptUpdate failed");
+        }
+    }
 }
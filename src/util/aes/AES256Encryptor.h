@@ -1,14 +1,49 @@
 #pragma once
+#include <cstdint>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "../kdf/KeyDerivationCache.h"
+
 class AES256Encryptor {
 public:
-    AES256Encryptor(const std::string& password, const std::vector<unsigned char>& salt);
+    // `params` must match the ones recorded when the data was encrypted
+    AES256Encryptor(const std::string& password, const std::vector<unsigned char>& salt,
+                    const KeyDerivation::Params& params = KeyDerivation::legacyParams());
+
+    // Uses a key derived ahead of time, e.g. one from prepareKey() shared across a batch.
+    explicit AES256Encryptor(KeyDerivationCache::KeyPtr key);
+
+    // Derives (once per process and password) a key under a reusable random salt.
+    // The salt and KDF parameters must be stored with the ciphertext.
+    static KeyDerivationCache::KeyPtr prepareKey(const std::string& password,
+                                                 const KeyDerivation::Params& params = KeyDerivation::defaultParams());
+
+    [[nodiscard]] const std::vector<unsigned char>& salt() const { return key_->salt; }
+    [[nodiscard]] const KeyDerivation::Params& kdfParams() const { return key_->params; }
 
     // Provide IV for encryption
     std::vector<unsigned char> encrypt(const std::vector<unsigned char>& plaintext, const std::vector<unsigned char>& iv) const;
     std::vector<unsigned char> decrypt(const std::vector<unsigned char>& ciphertext, const std::vector<unsigned char>& iv) const;
 
+    // CTR mode is its own inverse, so these both encrypt and decrypt. The buffer is split
+    // into chunks that run on the thread pool, each starting at its own counter block.
+    // `output` must be as large as `input`; the two may be the same buffer but must not
+    // otherwise overlap.
+    void transform(std::span<const unsigned char> input, std::span<unsigned char> output,
+                   const std::vector<unsigned char>& iv) const;
+    void transformInPlace(std::span<unsigned char> data, const std::vector<unsigned char>& iv) const;
+
+    // Counter block for the given 16-byte block index of a CTR stream started at `iv`.
+    static std::vector<unsigned char> counterAt(const std::vector<unsigned char>& iv, uint64_t blockIndex);
+
 private:
-    std::vector<unsigned char> key_;
+    void transformRange(std::span<const unsigned char> input, unsigned char* output,
+                        const std::vector<unsigned char>& counter) const;
+
+    // Multiple of the AES block size
+    static constexpr size_t ParallelChunkSize = 1024 * 1024;
+
+    KeyDerivationCache::KeyPtr key_;
 };
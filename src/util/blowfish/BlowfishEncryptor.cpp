@@ -1,4 +1,5 @@
 #include "BlowfishEncryptor.h"
+#include <algorithm>
 #include <stdexcept>
 
 // Initial P-array values (first 32 bits of fractional parts of pi)
@@ -196,7 +197,22 @@ const uint32_t BlowfishEncryptor::INITIAL_S[4][256] = {
     }
 };
 
-void BlowfishEncryptor::initializeContext(const std::string& key, const std::vector<unsigned char>& salt) {
+BlowfishEncryptor::BlowfishEncryptor(const std::string& password, const std::vector<unsigned char>& salt,
+                                     const Mode mode, const KeyDerivation::Params& params)
+    : BlowfishEncryptor(KeyDerivationCache::instance().derive(password, salt, params, KeySize), mode) {}
+
+BlowfishEncryptor::BlowfishEncryptor(const KeyDerivationCache::KeyPtr& key, const Mode mode) : mode(mode) {
+    if (!key || key->key.empty()) {
+        throw std::runtime_error("Blowfish requires a derived key");
+    }
+    initializeContext(key->key);
+}
+
+KeyDerivationCache::KeyPtr BlowfishEncryptor::prepareKey(const std::string& password, const KeyDerivation::Params& params) {
+    return KeyDerivationCache::instance().prepare(password, SaltSize, params, KeySize);
+}
+
+void BlowfishEncryptor::initializeContext(const std::span<const unsigned char> key) {
     // Copy initial P-array and S-boxes
     for (int i = 0; i < ROUNDS + 2; i++) {
         ctx.P[i] = INITIAL_P[i];
@@ -208,20 +224,12 @@ void BlowfishEncryptor::initializeContext(const std::string& key, const std::vec
         }
     }
 
-    // XOR P-array with key
-    std::vector<unsigned char> expandedKey;
-
-    // Combine key and salt
-    std::vector<unsigned char> keyBytes(key.begin(), key.end());
-    expandedKey.insert(expandedKey.end(), keyBytes.begin(), keyBytes.end());
-    expandedKey.insert(expandedKey.end(), salt.begin(), salt.end());
-
     // Repeat key to fill P-array
     size_t keyIndex = 0;
     for (int i = 0; i < ROUNDS + 2; i++) {
         uint32_t keyWord = 0;
         for (int j = 0; j < 4; j++) {
-            keyWord = (keyWord << 8) | expandedKey[keyIndex % expandedKey.size()];
+            keyWord = (keyWord << 8) | key[keyIndex % key.size()];
             keyIndex++;
         }
         ctx.P[i] ^= keyWord;
@@ -247,137 +255,181 @@ void BlowfishEncryptor::initializeContext(const std::string& key, const std::vec
     }
 }
 
-uint32_t BlowfishEncryptor::F(uint32_t x) const {
-    uint8_t a = (x >> 24) & 0xFF;
-    uint8_t b = (x >> 16) & 0xFF;
-    uint8_t c = (x >> 8) & 0xFF;
-    uint8_t d = x & 0xFF;
-
-    return ((ctx.S[0][a] + ctx.S[1][b]) ^ ctx.S[2][c]) + ctx.S[3][d];
+uint32_t BlowfishEncryptor::F(const uint32_t x) const {
+    return ((ctx.S[0][x >> 24] + ctx.S[1][(x >> 16) & 0xFF]) ^ ctx.S[2][(x >> 8) & 0xFF]) + ctx.S[3][x & 0xFF];
 }
 
 void BlowfishEncryptor::encryptBlock(uint32_t& left, uint32_t& right) const {
-    for (int i = 0; i < ROUNDS; i++) {
-        left ^= ctx.P[i];
-        right ^= F(left);
-        std::swap(left, right);
+    // Two rounds per iteration, so the halves never need swapping
+    uint32_t l = left, r = right;
+    for (int i = 0; i < ROUNDS; i += 2) {
+        l ^= ctx.P[i];
+        r ^= F(l) ^ ctx.P[i + 1];
+        l ^= F(r);
     }
-
-    // Undo last swap
-    std::swap(left, right);
-
-    right ^= ctx.P[ROUNDS];
-    left ^= ctx.P[ROUNDS + 1];
+    left = r ^ ctx.P[ROUNDS + 1];
+    right = l ^ ctx.P[ROUNDS];
 }
 
 void BlowfishEncryptor::decryptBlock(uint32_t& left, uint32_t& right) const {
-    for (int i = ROUNDS + 1; i > 1; i--) {
-        left ^= ctx.P[i];
-        right ^= F(left);
-        std::swap(left, right);
+    uint32_t l = left, r = right;
+    for (int i = ROUNDS + 1; i > 1; i -= 2) {
+        l ^= ctx.P[i];
+        r ^= F(l) ^ ctx.P[i - 1];
+        l ^= F(r);
     }
+    left = r ^ ctx.P[0];
+    right = l ^ ctx.P[1];
+}
 
-    // Undo last swap
-    std::swap(left, right);
+namespace {
+    uint32_t load32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+             | static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+    }
 
-    right ^= ctx.P[1];
-    left ^= ctx.P[0];
+    void store32(unsigned char* p, const uint32_t value) {
+        p[0] = static_cast<unsigned char>(value >> 24);
+        p[1] = static_cast<unsigned char>(value >> 16);
+        p[2] = static_cast<unsigned char>(value >> 8);
+        p[3] = static_cast<unsigned char>(value);
+    }
 }
 
-std::vector<unsigned char> BlowfishEncryptor::processBlocks(const std::vector<unsigned char>& data,
-                                                            const std::vector<unsigned char>& iv,
-                                                            bool encrypt) const {
+size_t BlowfishEncryptor::encryptedSize(const size_t plainSize) const {
+    // CBC always adds PKCS#5 padding, a whole block when the input is already aligned
+    return mode == Mode::CFB ? plainSize : (plainSize / BLOCK_SIZE + 1) * BLOCK_SIZE;
+}
+
+size_t BlowfishEncryptor::encrypt(const std::span<const unsigned char> input, const std::span<unsigned char> output,
+                                  const std::vector<unsigned char>& iv) const {
     if (iv.size() != BLOCK_SIZE) {
         throw std::invalid_argument("IV must be 8 bytes");
     }
+    if (output.size() < encryptedSize(input.size())) {
+        throw std::invalid_argument("Output buffer too small");
+    }
+    return mode == Mode::CFB ? processCFB(input, output.data(), iv, true) : encryptCBC(input, output.data(), iv);
+}
 
-    if (mode == Mode::CFB) {
-        // CFB-64 mode: no padding, can handle arbitrary length
-        std::vector<unsigned char> result;
-        std::vector<unsigned char> shiftReg = iv;
-        size_t dataLen = data.size();
-        result.reserve(dataLen);
-
-        for (size_t i = 0; i < dataLen; ) {
-            // Encrypt current shift register
-            uint32_t left = 0, right = 0;
-            // pack shiftReg into left/right
-            for (int j = 0; j < 4; ++j) {
-                left = (left << 8) | shiftReg[j];
-                right = (right << 8) | shiftReg[4 + j];
-            }
-            encryptBlock(left, right);
-            // unpack keystream
-            unsigned char keystream[BLOCK_SIZE];
-            for (int j = 0; j < 4; ++j) {
-                keystream[j] = (left >> ((3-j)*8)) & 0xFF;
-                keystream[4+j] = (right >> ((3-j)*8)) & 0xFF;
-            }
-            // process up to BLOCK_SIZE bytes
-            int chunk = std::min<size_t>(BLOCK_SIZE, dataLen - i);
-            for (int j = 0; j < chunk; ++j) {
-                unsigned char out = data[i+j] ^ keystream[j];
-                result.push_back(out);
-                // shift left shiftReg and append cipher byte
-                shiftReg.erase(shiftReg.begin());
-                shiftReg.push_back(out);
-            }
-            i += chunk;
-        }
-        return result;
+size_t BlowfishEncryptor::decrypt(const std::span<const unsigned char> input, const std::span<unsigned char> output,
+                                  const std::vector<unsigned char>& iv) const {
+    if (iv.size() != BLOCK_SIZE) {
+        throw std::invalid_argument("IV must be 8 bytes");
+    }
+    if (output.size() < input.size()) {
+        throw std::invalid_argument("Output buffer too small");
     }
+    return mode == Mode::CFB ? processCFB(input, output.data(), iv, false) : decryptCBC(input, output.data(), iv);
+}
+
+std::vector<unsigned char> BlowfishEncryptor::encrypt(const std::vector<unsigned char>& data,
+                                                      const std::vector<unsigned char>& iv) const {
+    std::vector<unsigned char> result(encryptedSize(data.size()));
+    encrypt(std::span<const unsigned char>(data), std::span<unsigned char>(result), iv);
+    return result;
+}
 
-    // CBC mode with PKCS#5 padding if encrypt; remove padding if decrypt
-    std::vector<unsigned char> buffer = data;
-    if (encrypt) {
-        size_t pad = BLOCK_SIZE - (buffer.size() % BLOCK_SIZE);
-        if (pad == 0) pad = BLOCK_SIZE;
-        buffer.insert(buffer.end(), pad, static_cast<unsigned char>(pad));
+std::vector<unsigned char> BlowfishEncryptor::decrypt(const std::vector<unsigned char>& data,
+                                                      const std::vector<unsigned char>& iv) const {
+    std::vector<unsigned char> result(data.size());
+    result.resize(decrypt(std::span<const unsigned char>(data), std::span<unsigned char>(result), iv));
+    return result;
+}
+
+size_t BlowfishEncryptor::processCFB(const std::span<const unsigned char> input, unsigned char* output,
+                                     const std::vector<unsigned char>& iv, const bool encrypt) const {
+    // CFB-64: the shift register always holds the previous ciphertext block
+    uint32_t left = load32(iv.data());
+    uint32_t right = load32(iv.data() + 4);
+
+    const unsigned char* in = input.data();
+    const size_t fullBlocks = input.size() / BLOCK_SIZE * BLOCK_SIZE;
+    for (size_t pos = 0; pos < fullBlocks; pos += BLOCK_SIZE) {
+        encryptBlock(left, right);
+
+        // Read the input block before writing, so input and output may alias
+        const uint32_t inLeft = load32(in + pos);
+        const uint32_t inRight = load32(in + pos + 4);
+        store32(output + pos, inLeft ^ left);
+        store32(output + pos + 4, inRight ^ right);
+
+        left = encrypt ? inLeft ^ left : inLeft;
+        right = encrypt ? inRight ^ right : inRight;
     }
 
-    std::vector<unsigned char> result;
-    std::vector<unsigned char> prevBlock = iv;
-    size_t total = buffer.size();
-    for (size_t pos = 0; pos < total; pos += BLOCK_SIZE) {
-        uint32_t left = 0, right = 0;
-        for (int j = 0; j < 4; ++j) left = (left << 8) | buffer[pos + j];
-        for (int j = 0; j < 4; ++j) right = (right << 8) | buffer[pos + 4 + j];
-
-        if (encrypt) {
-            // XOR with prev
-            uint32_t pl = 0, pr = 0;
-            for (int j = 0; j < 4; ++j) pl = (pl << 8) | prevBlock[j];
-            for (int j = 0; j < 4; ++j) pr = (pr << 8) | prevBlock[4 + j];
-            left ^= pl; right ^= pr;
-            encryptBlock(left, right);
-            // update prevBlock
-            for (int j = 0; j < 4; ++j) prevBlock[j] = (left >> ((3-j)*8)) & 0xFF;
-            for (int j = 0; j < 4; ++j) prevBlock[4+j] = (right >> ((3-j)*8)) & 0xFF;
-        } else {
-            uint32_t cl = left, cr = right;
-            decryptBlock(left, right);
-            uint32_t pl = 0, pr = 0;
-            for (int j = 0; j < 4; ++j) pl = (pl << 8) | prevBlock[j];
-            for (int j = 0; j < 4; ++j) pr = (pr << 8) | prevBlock[4 + j];
-            left ^= pl; right ^= pr;
-            // update prevBlock
-            for (int j = 0; j < 4; ++j) prevBlock[j] = (cl >> ((3-j)*8)) & 0xFF;
-            for (int j = 0; j < 4; ++j) prevBlock[4+j] = (cr >> ((3-j)*8)) & 0xFF;
+    // A trailing partial block only needs the keystream; nothing is fed back after it
+    if (fullBlocks < input.size()) {
+        encryptBlock(left, right);
+        unsigned char keystream[BLOCK_SIZE];
+        store32(keystream, left);
+        store32(keystream + 4, right);
+        for (size_t pos = fullBlocks; pos < input.size(); ++pos) {
+            output[pos] = in[pos] ^ keystream[pos - fullBlocks];
         }
-        // output block
-        for (int j = 0; j < 4; ++j) result.push_back((left >> ((3-j)*8)) & 0xFF);
-        for (int j = 0; j < 4; ++j) result.push_back((right >> ((3-j)*8)) & 0xFF);
+    }
+    return input.size();
+}
+
+size_t BlowfishEncryptor::encryptCBC(const std::span<const unsigned char> input, unsigned char* output,
+                                     const std::vector<unsigned char>& iv) const {
+    uint32_t left = load32(iv.data());
+    uint32_t right = load32(iv.data() + 4);
+
+    const size_t fullBlocks = input.size() / BLOCK_SIZE * BLOCK_SIZE;
+    for (size_t pos = 0; pos < fullBlocks; pos += BLOCK_SIZE) {
+        left ^= load32(input.data() + pos);
+        right ^= load32(input.data() + pos + 4);
+        encryptBlock(left, right);
+        store32(output + pos, left);
+        store32(output + pos + 4, right);
     }
 
-    if (!encrypt && !result.empty()) {
-        unsigned char padSize = result.back();
-        if (padSize > 0 && padSize <= BLOCK_SIZE) {
-            bool ok = true;
-            for (size_t i = result.size() - padSize; i < result.size(); ++i) {
-                if (result[i] != padSize) { ok = false; break; }
-            }
-            if (ok) result.resize(result.size() - padSize);
+    // Final block carries the remaining bytes plus PKCS#5 padding
+    unsigned char last[BLOCK_SIZE];
+    const size_t remaining = input.size() - fullBlocks;
+    std::copy_n(input.data() + fullBlocks, remaining, last);
+    std::fill(last + remaining, last + BLOCK_SIZE, static_cast<unsigned char>(BLOCK_SIZE - remaining));
+
+    left ^= load32(last);
+    right ^= load32(last + 4);
+    encryptBlock(left, right);
+    store32(output + fullBlocks, left);
+    store32(output + fullBlocks + 4, right);
+
+    return fullBlocks + BLOCK_SIZE;
+}
+
+size_t BlowfishEncryptor::decryptCBC(const std::span<const unsigned char> input, unsigned char* output,
+                                     const std::vector<unsigned char>& iv) const {
+    if (input.size() % BLOCK_SIZE != 0) {
+        throw std::invalid_argument("CBC ciphertext must be a multiple of 8 bytes");
+    }
+
+    uint32_t prevLeft = load32(iv.data());
+    uint32_t prevRight = load32(iv.data() + 4);
+
+    for (size_t pos = 0; pos < input.size(); pos += BLOCK_SIZE) {
+        const uint32_t cipherLeft = load32(input.data() + pos);
+        const uint32_t cipherRight = load32(input.data() + pos + 4);
+
+        uint32_t left = cipherLeft, right = cipherRight;
+        decryptBlock(left, right);
+        store32(output + pos, left ^ prevLeft);
+        store32(output + pos + 4, right ^ prevRight);
+
+        prevLeft = cipherLeft;
+        prevRight = cipherRight;
+    }
+
+    // Strip the padding when it is well formed; anything else is returned as is
+    size_t length = input.size();
+    if (length != 0) {
+        const unsigned char padSize = output[length - 1];
+        if (padSize > 0 && padSize <= BLOCK_SIZE
+            && std::all_of(output + length - padSize, output + length, [&](const unsigned char b) { return b == padSize; })) {
+            length -= padSize;
         }
     }
-    return result;
-}
\ No newline at end of file
+    return length;
+}
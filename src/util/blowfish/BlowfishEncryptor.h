@@ -1,7 +1,11 @@
 #pragma once
+#include <cstdint>
+#include <span>
 #include <vector>
 #include <string>
 
+#include "../kdf/KeyDerivationCache.h"
+
 class BlowfishEncryptor {
 public:
     enum class Mode { CBC, CFB };
@@ -22,30 +26,49 @@ private:
     // Initial S-boxes (first 32 bits of fractional parts of pi)
     static const uint32_t INITIAL_S[4][256];
 
-    void initializeContext(const std::string& key, const std::vector<unsigned char>& salt);
+    void initializeContext(std::span<const unsigned char> key);
     [[nodiscard]] uint32_t F(uint32_t x) const;
     void encryptBlock(uint32_t& left, uint32_t& right) const;
     void decryptBlock(uint32_t& left, uint32_t& right) const;
 
-    [[nodiscard]] std::vector<unsigned char> processBlocks(const std::vector<unsigned char>& data,
-                                                             const std::vector<unsigned char>& iv,
-                                                             bool encrypt) const;
+    // Block loops; each returns the number of bytes written to `output`
+    size_t processCFB(std::span<const unsigned char> input, unsigned char* output,
+                      const std::vector<unsigned char>& iv, bool encrypt) const;
+    size_t encryptCBC(std::span<const unsigned char> input, unsigned char* output,
+                      const std::vector<unsigned char>& iv) const;
+    size_t decryptCBC(std::span<const unsigned char> input, unsigned char* output,
+                      const std::vector<unsigned char>& iv) const;
 
 public:
-    BlowfishEncryptor(const std::string& key,
+    static constexpr size_t SaltSize = 8;
+    static constexpr size_t KeySize = 32;
+
+    // The key schedule is fed a KDF output rather than the raw password
+    BlowfishEncryptor(const std::string& password,
                       const std::vector<unsigned char>& salt,
-                      const Mode mode = Mode::CBC)
-        : mode(mode) {
-        initializeContext(key, salt);
-    }
+                      Mode mode = Mode::CBC,
+                      const KeyDerivation::Params& params = KeyDerivation::legacyParams());
 
-    [[nodiscard]] std::vector<unsigned char> encrypt(const std::vector<unsigned char>& data,
-                                                      const std::vector<unsigned char>& iv) const {
-        return processBlocks(data, iv, true);
-    }
+    // Uses a key derived ahead of time, e.g. one from prepareKey()
+    explicit BlowfishEncryptor(const KeyDerivationCache::KeyPtr& key, Mode mode = Mode::CBC);
+
+    // Same contract as AES256Encryptor::prepareKey: store key->salt and key->params with the output
+    static KeyDerivationCache::KeyPtr prepareKey(const std::string& password,
+                                                 const KeyDerivation::Params& params = KeyDerivation::defaultParams());
 
+    // Bytes encrypt() writes for `plainSize` input: the same for CFB, padded to whole blocks for CBC
+    [[nodiscard]] size_t encryptedSize(size_t plainSize) const;
+
+    // Write into a caller-provided buffer and return the number of bytes written. `output` needs
+    // encryptedSize(input.size()) bytes when encrypting and input.size() when decrypting; it may
+    // be the same buffer as `input`. CBC decryption strips well-formed padding.
+    size_t encrypt(std::span<const unsigned char> input, std::span<unsigned char> output,
+                   const std::vector<unsigned char>& iv) const;
+    size_t decrypt(std::span<const unsigned char> input, std::span<unsigned char> output,
+                   const std::vector<unsigned char>& iv) const;
+
+    [[nodiscard]] std::vector<unsigned char> encrypt(const std::vector<unsigned char>& data,
+                                                     const std::vector<unsigned char>& iv) const;
     [[nodiscard]] std::vector<unsigned char> decrypt(const std::vector<unsigned char>& data,
-                                       const std::vector<unsigned char>& iv) const {
-        return processBlocks(data, iv, false);
-    }
-};
\ No newline at end of file
+                                                     const std::vector<unsigned char>& iv) const;
+};
@@ -0,0 +1,227 @@
+#include "KeyDerivation.h"
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/core_names.h>
+#include <openssl/opensslv.h>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+    constexpr unsigned char Magic[4] = { 'K', 'D', 'F', 1 };
+
+    // scrypt block size; fixed, so it is not part of the encoded parameters
+    constexpr uint64_t ScryptBlockSize = 8;
+
+    std::mutex defaultsMutex;
+    KeyDerivation::Params defaults = KeyDerivation::legacyParams();
+
+    void putLE32(std::vector<unsigned char>& out, const uint32_t value) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+    }
+
+    uint32_t getLE32(const std::span<const unsigned char> in) {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(in[i]) << (i * 8);
+        return value;
+    }
+
+    // Bounds keep a crafted header from requesting an absurd amount of work or memory
+    void validate(const KeyDerivation::Params& params) {
+        using KeyDerivation::Algorithm;
+        bool ok = false;
+        switch (params.algorithm) {
+            case Algorithm::Pbkdf2Sha256:
+                ok = params.cost >= 1000 && params.cost <= 10000000 && params.parallelism == 1;
+                break;
+            case Algorithm::Scrypt:
+                ok = params.cost >= 10 && params.cost <= 24 && params.parallelism >= 1 && params.parallelism <= 16;
+                break;
+            case Algorithm::Argon2id:
+                ok = params.cost >= 1 && params.cost <= 16 && params.parallelism >= 1 && params.parallelism <= 64
+                    && params.memoryKiB >= 8 * params.parallelism && params.memoryKiB <= 4u * 1024 * 1024;
+                break;
+        }
+        if (!ok) {
+            throw std::runtime_error("Invalid key derivation parameters: " + KeyDerivation::describe(params));
+        }
+    }
+
+    void derivePbkdf2(const std::string& password, const std::span<const unsigned char> salt,
+                      const KeyDerivation::Params& params, const std::span<unsigned char> key) {
+        if (!PKCS5_PBKDF2_HMAC(password.c_str(), static_cast<int>(password.size()),
+                               salt.data(), static_cast<int>(salt.size()),
+                               static_cast<int>(params.cost), EVP_sha256(),
+                               static_cast<int>(key.size()), key.data())) {
+            throw std::runtime_error("Failed to derive key with PBKDF2");
+        }
+    }
+
+    void deriveScrypt(const std::string& password, const std::span<const unsigned char> salt,
+                      const KeyDerivation::Params& params, const std::span<unsigned char> key) {
+        const uint64_t n = uint64_t{1} << params.cost;
+        // OpenSSL's default limit is 32 MiB; allow exactly what these parameters need
+        const uint64_t maxMemory = 128 * ScryptBlockSize * (n + params.parallelism + 2) + 1024 * 1024;
+
+        if (!EVP_PBE_scrypt(password.data(), password.size(), salt.data(), salt.size(),
+                            n, ScryptBlockSize, params.parallelism, maxMemory, key.data(), key.size())) {
+            throw std::runtime_error("Failed to derive key with scrypt");
+        }
+    }
+
+    void deriveArgon2id(const std::string& password, const std::span<const unsigned char> salt,
+                        const KeyDerivation::Params& params, const std::span<unsigned char> key) {
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        EVP_KDF* kdf = EVP_KDF_fetch(nullptr, "ARGON2ID", nullptr);
+        if (!kdf) throw std::runtime_error("Argon2id is not provided by this OpenSSL build");
+        EVP_KDF_CTX* ctx = EVP_KDF_CTX_new(kdf);
+        EVP_KDF_free(kdf);
+        if (!ctx) throw std::runtime_error("EVP_KDF_CTX_new failed");
+
+        uint32_t passes = params.cost;
+        uint32_t memory = params.memoryKiB;
+        uint32_t lanes = params.parallelism;
+        uint32_t threads = 1;
+        const OSSL_PARAM settings[] = {
+            OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ITER, &passes),
+            OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_MEMCOST, &memory),
+            OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_LANES, &lanes),
+            OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_THREADS, &threads),
+            OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, const_cast<unsigned char*>(salt.data()), salt.size()),
+            OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, const_cast<char*>(password.data()), password.size()),
+            OSSL_PARAM_construct_end()
+        };
+
+        const bool ok = EVP_KDF_derive(ctx, key.data(), key.size(), settings) == 1;
+        EVP_KDF_CTX_free(ctx);
+        if (!ok) throw std::runtime_error("Failed to derive key with Argon2id");
+#else
+        (void)password; (void)salt; (void)params; (void)key;
+        throw std::runtime_error("Argon2id requires OpenSSL 3.2 or newer");
+#endif
+    }
+}
+
+namespace KeyDerivation {
+    Params legacyParams() {
+        return Params{ .algorithm = Algorithm::Pbkdf2Sha256, .cost = 100000, .memoryKiB = 0, .parallelism = 1 };
+    }
+
+    Params preset(const Algorithm algorithm, const std::string& cost) {
+        int level;
+        if (cost == "low") level = 0;
+        else if (cost == "standard") level = 1;
+        else if (cost == "high") level = 2;
+        else throw std::runtime_error("Unknown KDF cost: " + cost + " (expected low, standard or high)");
+
+        switch (algorithm) {
+            case Algorithm::Pbkdf2Sha256: {
+                constexpr uint32_t iterations[] = { 10000, 100000, 600000 };
+                return Params{ .algorithm = algorithm, .cost = iterations[level], .memoryKiB = 0, .parallelism = 1 };
+            }
+            case Algorithm::Scrypt: {
+                // 16, 64 and 256 MiB
+                constexpr uint32_t logN[] = { 14, 16, 18 };
+                return Params{ .algorithm = algorithm, .cost = logN[level], .memoryKiB = 0, .parallelism = 1 };
+            }
+            case Algorithm::Argon2id: {
+                constexpr uint32_t passes[] = { 1, 2, 3 };
+                constexpr uint32_t memoryKiB[] = { 19 * 1024, 64 * 1024, 256 * 1024 };
+                constexpr uint32_t lanes[] = { 1, 1, 4 };
+                return Params{ .algorithm = algorithm, .cost = passes[level], .memoryKiB = memoryKiB[level], .parallelism = lanes[level] };
+            }
+        }
+        throw std::runtime_error("Unknown KDF algorithm");
+    }
+
+    Algorithm parseAlgorithm(const std::string& name) {
+        if (name == "pbkdf2") return Algorithm::Pbkdf2Sha256;
+        if (name == "scrypt") return Algorithm::Scrypt;
+        if (name == "argon2id") return Algorithm::Argon2id;
+        throw std::runtime_error("Unknown KDF: " + name + " (expected pbkdf2, scrypt or argon2id)");
+    }
+
+    std::string algorithmName(const Algorithm algorithm) {
+        switch (algorithm) {
+            case Algorithm::Pbkdf2Sha256: return "pbkdf2";
+            case Algorithm::Scrypt: return "scrypt";
+            case Algorithm::Argon2id: return "argon2id";
+        }
+        return "unknown";
+    }
+
+    std::string describe(const Params& params) {
+        switch (params.algorithm) {
+            case Algorithm::Pbkdf2Sha256:
+                return "pbkdf2-sha256, " + std::to_string(params.cost) + " iterations";
+            case Algorithm::Scrypt:
+                return "scrypt, N=2^" + std::to_string(params.cost) + ", p=" + std::to_string(params.parallelism);
+            case Algorithm::Argon2id:
+                return "argon2id, " + std::to_string(params.cost) + " passes, " + std::to_string(params.memoryKiB)
+                    + " KiB, " + std::to_string(params.parallelism) + " lanes";
+        }
+        return "unknown KDF";
+    }
+
+    bool isAvailable(const Algorithm algorithm) {
+        if (algorithm != Algorithm::Argon2id) return true;
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        EVP_KDF* kdf = EVP_KDF_fetch(nullptr, "ARGON2ID", nullptr);
+        EVP_KDF_free(kdf);
+        return kdf != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    void setDefaultParams(const Params& params) {
+        validate(params);
+        if (!isAvailable(params.algorithm)) {
+            throw std::runtime_error(algorithmName(params.algorithm) + " is not available in this build");
+        }
+        std::lock_guard lock(defaultsMutex);
+        defaults = params;
+    }
+
+    Params defaultParams() {
+        std::lock_guard lock(defaultsMutex);
+        return defaults;
+    }
+
+    std::vector<unsigned char> encode(const Params& params) {
+        std::vector<unsigned char> out(std::begin(Magic), std::end(Magic));
+        out.reserve(EncodedSize);
+        out.push_back(static_cast<unsigned char>(params.algorithm));
+        out.push_back(static_cast<unsigned char>(params.parallelism));
+        out.push_back(0);
+        out.push_back(0);
+        putLE32(out, params.cost);
+        putLE32(out, params.memoryKiB);
+        return out;
+    }
+
+    std::optional<Params> decode(const std::span<const unsigned char> data) {
+        if (data.size() < EncodedSize || !std::equal(std::begin(Magic), std::end(Magic), data.begin())) {
+            return std::nullopt;
+        }
+
+        const Params params{
+            .algorithm = static_cast<Algorithm>(data[4]),
+            .cost = getLE32(data.subspan(8)),
+            .memoryKiB = getLE32(data.subspan(12)),
+            .parallelism = data[5]
+        };
+        validate(params);
+        return params;
+    }
+
+    void derive(const std::string& password, const std::span<const unsigned char> salt,
+                const Params& params, const std::span<unsigned char> key) {
+        switch (params.algorithm) {
+            case Algorithm::Pbkdf2Sha256: derivePbkdf2(password, salt, params, key); return;
+            case Algorithm::Scrypt: deriveScrypt(password, salt, params, key); return;
+            case Algorithm::Argon2id: deriveArgon2id(password, salt, params, key); return;
+        }
+        throw std::runtime_error("Unknown KDF algorithm");
+    }
+}
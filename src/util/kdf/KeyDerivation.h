@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Password-based key derivation with a selectable algorithm and cost. The parameters
+// are encoded into a small block that is stored next to the salt, so decryption always
+// uses whatever the data was encrypted with.
+namespace KeyDerivation {
+    enum class Algorithm : uint8_t {
+        Pbkdf2Sha256 = 1,
+        Scrypt = 2,
+        Argon2id = 3
+    };
+
+    struct Params {
+        Algorithm algorithm = Algorithm::Pbkdf2Sha256;
+        uint32_t cost = 100000;   // PBKDF2 iterations, scrypt log2(N) or Argon2 passes
+        uint32_t memoryKiB = 0;   // Argon2 only
+        uint32_t parallelism = 1; // scrypt p or Argon2 lanes
+
+        bool operator==(const Params&) const = default;
+    };
+
+    // Bytes produced by encode(), including the 4-byte magic
+    constexpr size_t EncodedSize = 16;
+
+    // PBKDF2-SHA256 with 100000 iterations, used by everything written before parameters were recorded
+    [[nodiscard]] Params legacyParams();
+
+    // Cost presets: "low" for bulk internal data, "standard", "high" for files that leave the machine
+    [[nodiscard]] Params preset(Algorithm algorithm, const std::string& cost);
+    [[nodiscard]] Algorithm parseAlgorithm(const std::string& name);
+    [[nodiscard]] std::string algorithmName(Algorithm algorithm);
+    [[nodiscard]] std::string describe(const Params& params);
+    [[nodiscard]] bool isAvailable(Algorithm algorithm);
+
+    // Parameters used for new encryptions; decryption always uses the recorded ones
+    void setDefaultParams(const Params& params);
+    [[nodiscard]] Params defaultParams();
+
+    [[nodiscard]] std::vector<unsigned char> encode(const Params& params);
+    // Returns nothing if `data` does not start with a parameter block. Throws if the block
+    // is present but describes an unknown algorithm or an unreasonable cost.
+    [[nodiscard]] std::optional<Params> decode(std::span<const unsigned char> data);
+
+    void derive(const std::string& password, std::span<const unsigned char> salt,
+                const Params& params, std::span<unsigned char> key);
+}
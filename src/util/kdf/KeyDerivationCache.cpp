@@ -0,0 +1,134 @@
+#include "KeyDerivationCache.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+    std::string digestOf(const std::string& domain, const std::string& password,
+                         const std::vector<unsigned char>& salt, const KeyDerivation::Params& params,
+                         const size_t keyLength) {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        if (!ctx) throw std::runtime_error("EVP_MD_CTX_new failed");
+
+        // Lengths first so that different splits of the same bytes cannot collide
+        const uint64_t header[] = { domain.size(), password.size(), salt.size(), keyLength };
+        const std::vector<unsigned char> encodedParams = KeyDerivation::encode(params);
+
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLen = 0;
+        const bool ok = EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr)
+            && EVP_DigestUpdate(ctx, header, sizeof(header))
+            && EVP_DigestUpdate(ctx, encodedParams.data(), encodedParams.size())
+            && EVP_DigestUpdate(ctx, domain.data(), domain.size())
+            && EVP_DigestUpdate(ctx, password.data(), password.size())
+            && EVP_DigestUpdate(ctx, salt.data(), salt.size())
+            && EVP_DigestFinal_ex(ctx, digest, &digestLen);
+        EVP_MD_CTX_free(ctx);
+
+        if (!ok) throw std::runtime_error("Failed to hash key derivation inputs");
+        return { reinterpret_cast<const char*>(digest), digestLen };
+    }
+
+    KeyDerivationCache::KeyPtr runKdf(const std::string& password, const std::vector<unsigned char>& salt,
+                                      const KeyDerivation::Params& params, const size_t keyLength) {
+        auto derived = std::make_shared<KeyDerivationCache::DerivedKey>();
+        derived->params = params;
+        derived->salt = salt;
+        derived->key.resize(keyLength);
+        KeyDerivation::derive(password, salt, params, derived->key);
+        return derived;
+    }
+}
+
+KeyDerivationCache::DerivedKey::~DerivedKey() {
+    if (!key.empty()) {
+        OPENSSL_cleanse(key.data(), key.size());
+    }
+}
+
+KeyDerivationCache& KeyDerivationCache::instance() {
+    static KeyDerivationCache cache;
+    return cache;
+}
+
+KeyDerivationCache::KeyPtr KeyDerivationCache::derive(const std::string& password, const std::vector<unsigned char>& salt,
+                                                      const KeyDerivation::Params& params, const size_t keyLength) {
+    return lookupOrDerive(digestOf("derive", password, salt, params, keyLength), [&] {
+        return runKdf(password, salt, params, keyLength);
+    });
+}
+
+KeyDerivationCache::KeyPtr KeyDerivationCache::prepare(const std::string& password, const size_t saltLength,
+                                                       const KeyDerivation::Params& params, const size_t keyLength) {
+    const std::vector<unsigned char> saltShape(saltLength, 0);
+    return lookupOrDerive(digestOf("prepare", password, saltShape, params, keyLength), [&] {
+        std::vector<unsigned char> salt(saltLength);
+        if (!RAND_bytes(salt.data(), static_cast<int>(saltLength))) {
+            throw std::runtime_error("Failed to generate random salt");
+        }
+
+        KeyPtr prepared = runKdf(password, salt, params, keyLength);
+
+        // Decrypting something encrypted with this salt should not derive the key again
+        lookupOrDerive(digestOf("derive", password, salt, params, keyLength), [&] { return prepared; });
+        return prepared;
+    });
+}
+
+KeyDerivationCache::KeyPtr KeyDerivationCache::lookupOrDerive(const std::string& digest, const std::function<KeyPtr()>& derive) {
+    std::promise<KeyPtr> promise;
+    std::shared_future<KeyPtr> future;
+    bool owner = false;
+
+    {
+        std::lock_guard lock(mutex);
+        if (const auto it = index.find(digest); it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            future = it->second->value;
+        } else {
+            future = promise.get_future().share();
+            lru.push_front(Entry{ digest, future });
+            index[digest] = lru.begin();
+            evictLocked();
+            owner = true;
+        }
+    }
+
+    if (owner) {
+        try {
+            promise.set_value(derive());
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+
+            std::lock_guard lock(mutex);
+            if (const auto it = index.find(digest); it != index.end()) {
+                lru.erase(it->second);
+                index.erase(it);
+            }
+        }
+    }
+
+    return future.get();
+}
+
+void KeyDerivationCache::evictLocked() {
+    while (lru.size() > capacity) {
+        index.erase(lru.back().digest);
+        lru.pop_back();
+    }
+}
+
+void KeyDerivationCache::setCapacity(const size_t entries) {
+    std::lock_guard lock(mutex);
+    capacity = std::max<size_t>(1, entries);
+    evictLocked();
+}
+
+void KeyDerivationCache::clear() {
+    std::lock_guard lock(mutex);
+    index.clear();
+    lru.clear();
+}
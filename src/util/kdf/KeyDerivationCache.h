@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "KeyDerivation.h"
+
+// Process-wide, bounded cache of password-derived keys. Entries are indexed by a SHA-256
+// digest of the inputs (never the password itself) and key material is wiped with
+// OPENSSL_cleanse once the last user of an evicted entry lets go of it.
+class KeyDerivationCache {
+public:
+    struct DerivedKey {
+        KeyDerivation::Params params;
+        std::vector<unsigned char> salt;
+        std::vector<unsigned char> key;
+
+        DerivedKey() = default;
+        DerivedKey(const DerivedKey&) = delete;
+        DerivedKey& operator=(const DerivedKey&) = delete;
+        ~DerivedKey();
+    };
+    using KeyPtr = std::shared_ptr<const DerivedKey>;
+
+    static KeyDerivationCache& instance();
+
+    // Key for (password, salt, params); the KDF only runs on a cache miss. Concurrent
+    // requests for the same inputs wait for a single derivation.
+    KeyPtr derive(const std::string& password, const std::vector<unsigned char>& salt,
+                  const KeyDerivation::Params& params, size_t keyLength);
+
+    // Pre-derives a key under a random salt that is chosen once per password and then
+    // reused, so every encryption in this process (all repetitions of a step, a capacity
+    // check followed by the real embed, a whole batch) shares one KDF run. Callers still
+    // use a fresh IV per message and store the returned salt alongside the ciphertext.
+    KeyPtr prepare(const std::string& password, size_t saltLength,
+                   const KeyDerivation::Params& params, size_t keyLength);
+
+    void setCapacity(size_t entries);
+    void clear();
+
+private:
+    struct Entry {
+        std::string digest;
+        std::shared_future<KeyPtr> value;
+    };
+
+    KeyDerivationCache() = default;
+
+    KeyPtr lookupOrDerive(const std::string& digest, const std::function<KeyPtr()>& derive);
+    void evictLocked();
+
+    std::mutex mutex;
+    std::list<Entry> lru; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t capacity = 64;
+};
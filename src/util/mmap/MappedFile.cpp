@@ -0,0 +1,59 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->length = static_cast<size_t>(std::filesystem::file_size(path));
+    // Nothing to map; data() stays null and size() zero
+    if (file->length == 0) return file;
+
+#if defined(_WIN32)
+    const HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Error: could not open " + path.string());
+    }
+    const HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping) {
+        throw std::runtime_error("Error: could not map " + path.string());
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, file->length);
+    CloseHandle(mapping);
+    if (!view) {
+        throw std::runtime_error("Error: could not map " + path.string());
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error: could not open " + path.string());
+    }
+    void* view = mmap(nullptr, file->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Error: could not map " + path.string());
+    }
+#endif
+
+    file->bytes = static_cast<unsigned char*>(view);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (!bytes) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(bytes);
+#else
+    munmap(bytes, length);
+#endif
+}
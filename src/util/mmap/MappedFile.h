@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+// A whole file mapped into memory, copy-on-write: the bytes can be modified in memory,
+// but nothing is ever written back to the file. Pages are only read from disk when
+// first touched, so a reader that needs a small part of a large file pays for that part.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    static std::shared_ptr<MappedFile> open(const std::filesystem::path& path);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] unsigned char* data() const { return bytes; }
+    [[nodiscard]] size_t size() const { return length; }
+    [[nodiscard]] std::span<unsigned char> view() const { return { bytes, length }; }
+
+private:
+    MappedFile() = default;
+
+    unsigned char* bytes = nullptr;
+    size_t length = 0;
+};
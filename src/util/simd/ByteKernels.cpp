@@ -0,0 +1,305 @@
+#include "ByteKernels.h"
+#include "CpuFeatures.h"
+#include <stdexcept>
+#include <numeric>
+
+namespace ByteKernels {
+
+namespace {
+    constexpr size_t MaxVectorWidth = 64;
+
+    struct Dispatch {
+        Isa isa;
+        void (*xorKey)(unsigned char* data, size_t size, const RepeatingKey& key, size_t pos);
+        void (*rotl)(unsigned char* data, size_t size, unsigned int n);
+        void (*add)(unsigned char* data, size_t size, unsigned char value);
+        void (*bitNot)(unsigned char* data, size_t size);
+    };
+
+    // Scalar fallback. Also finishes the tails left over by the vector variants.
+
+    size_t xorTail(unsigned char* data, const size_t size, const RepeatingKey& key, size_t pos) {
+        for (size_t i = 0; i < size; ++i) {
+            data[i] ^= *key.at(pos);
+            if (++pos == key.period()) pos = 0;
+        }
+        return pos;
+    }
+
+    void xorScalar(unsigned char* data, const size_t size, const RepeatingKey& key, const size_t pos) {
+        xorTail(data, size, key, pos);
+    }
+
+    void rotlScalar(unsigned char* data, const size_t size, const unsigned int n) {
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<unsigned char>((data[i] << n) | (data[i] >> (8 - n)));
+        }
+    }
+
+    void addScalar(unsigned char* data, const size_t size, const unsigned char value) {
+        for (size_t i = 0; i < size; ++i) data[i] += value;
+    }
+
+    void notScalar(unsigned char* data, const size_t size) {
+        for (size_t i = 0; i < size; ++i) data[i] = ~data[i];
+    }
+
+    constexpr Dispatch ScalarDispatch{ Isa::Scalar, xorScalar, rotlScalar, addScalar, notScalar };
+
+#ifdef HNS_X86
+    // Byte rotation has no native instruction: shift 16-bit lanes both ways and mask
+    // off the bits that crossed into the neighbouring byte.
+
+    // ---- SSE2 ----
+
+    HNS_TARGET("sse2")
+    void xorSse2(unsigned char* data, const size_t size, const RepeatingKey& key, size_t pos) {
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.at(pos)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(v, k));
+            pos += 16;
+            if (pos >= key.period()) pos -= key.period();
+        }
+        xorTail(data + i, size - i, key, pos);
+    }
+
+    HNS_TARGET("sse2")
+    void rotlSse2(unsigned char* data, const size_t size, const unsigned int n) {
+        const __m128i left = _mm_cvtsi32_si128(static_cast<int>(n));
+        const __m128i right = _mm_cvtsi32_si128(static_cast<int>(8 - n));
+        const __m128i maskHigh = _mm_set1_epi8(static_cast<char>((0xFF << n) & 0xFF));
+        const __m128i maskLow = _mm_set1_epi8(static_cast<char>(0xFF >> (8 - n)));
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i r = _mm_or_si128(_mm_and_si128(_mm_sll_epi16(v, left), maskHigh),
+                                           _mm_and_si128(_mm_srl_epi16(v, right), maskLow));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), r);
+        }
+        rotlScalar(data + i, size - i, n);
+    }
+
+    HNS_TARGET("sse2")
+    void addSse2(unsigned char* data, const size_t size, const unsigned char value) {
+        const __m128i add = _mm_set1_epi8(static_cast<char>(value));
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_add_epi8(v, add));
+        }
+        addScalar(data + i, size - i, value);
+    }
+
+    HNS_TARGET("sse2")
+    void notSse2(unsigned char* data, const size_t size) {
+        const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(v, ones));
+        }
+        notScalar(data + i, size - i);
+    }
+
+    // ---- AVX2 ----
+
+    HNS_TARGET("avx2")
+    void xorAvx2(unsigned char* data, const size_t size, const RepeatingKey& key, size_t pos) {
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key.at(pos)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(v, k));
+            pos += 32;
+            if (pos >= key.period()) pos -= key.period();
+        }
+        xorTail(data + i, size - i, key, pos);
+    }
+
+    HNS_TARGET("avx2")
+    void rotlAvx2(unsigned char* data, const size_t size, const unsigned int n) {
+        const __m128i left = _mm_cvtsi32_si128(static_cast<int>(n));
+        const __m128i right = _mm_cvtsi32_si128(static_cast<int>(8 - n));
+        const __m256i maskHigh = _mm256_set1_epi8(static_cast<char>((0xFF << n) & 0xFF));
+        const __m256i maskLow = _mm256_set1_epi8(static_cast<char>(0xFF >> (8 - n)));
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i r = _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi16(v, left), maskHigh),
+                                              _mm256_and_si256(_mm256_srl_epi16(v, right), maskLow));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), r);
+        }
+        rotlScalar(data + i, size - i, n);
+    }
+
+    HNS_TARGET("avx2")
+    void addAvx2(unsigned char* data, const size_t size, const unsigned char value) {
+        const __m256i add = _mm256_set1_epi8(static_cast<char>(value));
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_add_epi8(v, add));
+        }
+        addScalar(data + i, size - i, value);
+    }
+
+    HNS_TARGET("avx2")
+    void notAvx2(unsigned char* data, const size_t size) {
+        const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(v, ones));
+        }
+        notScalar(data + i, size - i);
+    }
+
+    // ---- AVX-512 (byte arithmetic needs the BW extension) ----
+
+    HNS_TARGET("avx512f,avx512bw")
+    void xorAvx512(unsigned char* data, const size_t size, const RepeatingKey& key, size_t pos) {
+        size_t i = 0;
+        for (; i + 64 <= size; i += 64) {
+            const __m512i v = _mm512_loadu_si512(data + i);
+            const __m512i k = _mm512_loadu_si512(key.at(pos));
+            _mm512_storeu_si512(data + i, _mm512_xor_si512(v, k));
+            pos += 64;
+            if (pos >= key.period()) pos -= key.period();
+        }
+        xorTail(data + i, size - i, key, pos);
+    }
+
+    HNS_TARGET("avx512f,avx512bw")
+    void rotlAvx512(unsigned char* data, const size_t size, const unsigned int n) {
+        const __m128i left = _mm_cvtsi32_si128(static_cast<int>(n));
+        const __m128i right = _mm_cvtsi32_si128(static_cast<int>(8 - n));
+        const __m512i maskHigh = _mm512_set1_epi8(static_cast<char>((0xFF << n) & 0xFF));
+        const __m512i maskLow = _mm512_set1_epi8(static_cast<char>(0xFF >> (8 - n)));
+        size_t i = 0;
+        for (; i + 64 <= size; i += 64) {
+            const __m512i v = _mm512_loadu_si512(data + i);
+            const __m512i r = _mm512_or_si512(_mm512_and_si512(_mm512_sll_epi16(v, left), maskHigh),
+                                              _mm512_and_si512(_mm512_srl_epi16(v, right), maskLow));
+            _mm512_storeu_si512(data + i, r);
+        }
+        rotlScalar(data + i, size - i, n);
+    }
+
+    HNS_TARGET("avx512f,avx512bw")
+    void addAvx512(unsigned char* data, const size_t size, const unsigned char value) {
+        const __m512i add = _mm512_set1_epi8(static_cast<char>(value));
+        size_t i = 0;
+        for (; i + 64 <= size; i += 64) {
+            const __m512i v = _mm512_loadu_si512(data + i);
+            _mm512_storeu_si512(data + i, _mm512_add_epi8(v, add));
+        }
+        addScalar(data + i, size - i, value);
+    }
+
+    HNS_TARGET("avx512f,avx512bw")
+    void notAvx512(unsigned char* data, const size_t size) {
+        const __m512i ones = _mm512_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for (; i + 64 <= size; i += 64) {
+            const __m512i v = _mm512_loadu_si512(data + i);
+            _mm512_storeu_si512(data + i, _mm512_xor_si512(v, ones));
+        }
+        notScalar(data + i, size - i);
+    }
+
+    constexpr Dispatch Sse2Dispatch{ Isa::SSE2, xorSse2, rotlSse2, addSse2, notSse2 };
+    constexpr Dispatch Avx2Dispatch{ Isa::AVX2, xorAvx2, rotlAvx2, addAvx2, notAvx2 };
+    constexpr Dispatch Avx512Dispatch{ Isa::AVX512, xorAvx512, rotlAvx512, addAvx512, notAvx512 };
+#endif
+
+    bool cpuSupports(const Isa isa) {
+        const CpuFeatures::Features& cpu = CpuFeatures::detect();
+        switch (isa) {
+            case Isa::Scalar: return true;
+            case Isa::SSE2:   return cpu.sse2;
+            case Isa::AVX2:   return cpu.avx2;
+            case Isa::AVX512: return cpu.avx512bw;
+        }
+        return false;
+    }
+
+    const Dispatch* dispatchFor(const Isa isa) {
+#ifdef HNS_X86
+        switch (isa) {
+            case Isa::AVX512: return &Avx512Dispatch;
+            case Isa::AVX2:   return &Avx2Dispatch;
+            case Isa::SSE2:   return &Sse2Dispatch;
+            case Isa::Scalar: break;
+        }
+#endif
+        return &ScalarDispatch;
+    }
+
+    CpuFeatures::DispatchSlot<Dispatch>& active() {
+        static CpuFeatures::DispatchSlot<Dispatch> slot{ dispatchFor(detectIsa()) };
+        return slot;
+    }
+}
+
+Isa detectIsa() {
+    for (const Isa isa : { Isa::AVX512, Isa::AVX2, Isa::SSE2 }) {
+        if (cpuSupports(isa)) return isa;
+    }
+    return Isa::Scalar;
+}
+
+Isa activeIsa() {
+    return active().get().isa;
+}
+
+void setIsa(Isa isa) {
+    while (isa != Isa::Scalar && !cpuSupports(isa)) {
+        isa = static_cast<Isa>(static_cast<int>(isa) - 1);
+    }
+    active().set(dispatchFor(isa));
+}
+
+std::string isaName(const Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+RepeatingKey::RepeatingKey(const std::span<const unsigned char> key)
+    : keySize_(key.size()), period_(std::lcm(key.size(), MaxVectorWidth)) {
+    if (key.empty()) {
+        throw std::invalid_argument("Repeating key must not be empty");
+    }
+
+    // One extra vector past the period so a full-width load never runs off the end
+    pattern.resize(period_ + MaxVectorWidth);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        pattern[i] = key[i % keySize_];
+    }
+}
+
+void xorRepeatingKey(const std::span<unsigned char> data, const RepeatingKey& key, const size_t offset) {
+    active().get().xorKey(data.data(), data.size(), key, offset % key.period());
+}
+
+void rotateLeft(const std::span<unsigned char> data, unsigned int n) {
+    n %= 8;
+    if (n == 0) return;
+    active().get().rotl(data.data(), data.size(), n);
+}
+
+void addConstant(const std::span<unsigned char> data, const unsigned char value) {
+    if (value == 0) return;
+    active().get().add(data.data(), data.size(), value);
+}
+
+void bitwiseNot(const std::span<unsigned char> data) {
+    active().get().bitNot(data.data(), data.size());
+}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+// Byte-wise kernels used by the pixel-local ciphers. Each kernel has a scalar
+// fallback plus SSE2/AVX2/AVX-512 variants that are picked at runtime from the
+// CPU's capabilities.
+namespace ByteKernels {
+
+    enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+    // Best instruction set supported by this CPU.
+    Isa detectIsa();
+
+    // Instruction set the kernels currently dispatch to.
+    Isa activeIsa();
+
+    // Forces a specific instruction set (clamped to what the CPU supports). Used by benchmarks.
+    void setIsa(Isa isa);
+
+    std::string isaName(Isa isa);
+
+    // A key repeated to a multiple of the widest vector so any block offset can be served
+    // by straight vector loads instead of a modulo per byte.
+    class RepeatingKey {
+    public:
+        explicit RepeatingKey(std::span<const unsigned char> key);
+
+        [[nodiscard]] size_t period() const { return period_; }
+        [[nodiscard]] size_t keySize() const { return keySize_; }
+        [[nodiscard]] const unsigned char* at(size_t pos) const { return pattern.data() + pos; }
+
+    private:
+        size_t keySize_;
+        size_t period_;
+        std::vector<unsigned char> pattern;
+    };
+
+    // data[i] ^= key[(offset + i) % key.size()]
+    void xorRepeatingKey(std::span<unsigned char> data, const RepeatingKey& key, size_t offset);
+
+    // Rotates every byte left by n bits (n is taken mod 8).
+    void rotateLeft(std::span<unsigned char> data, unsigned int n);
+
+    // Adds value to every byte, wrapping mod 256. Subtraction is addConstant(data, -value).
+    void addConstant(std::span<unsigned char> data, unsigned char value);
+
+    void bitwiseNot(std::span<unsigned char> data);
+}
@@ -0,0 +1,41 @@
+#include "CpuFeatures.h"
+
+#if defined(HNS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace CpuFeatures {
+
+namespace {
+    Features probe() {
+        Features features;
+#if defined(HNS_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        features.sse2 = (info[3] & (1 << 26)) != 0;
+        // AVX state has to be enabled by the OS (XCR0), not just present in the CPU
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            features.bmi2 = (info[1] & (1 << 8)) != 0;
+            features.avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+            features.avx512bw = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        }
+#elif defined(HNS_X86)
+        features.sse2 = __builtin_cpu_supports("sse2");
+        features.bmi2 = __builtin_cpu_supports("bmi2");
+        features.avx2 = __builtin_cpu_supports("avx2");
+        features.avx512bw = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        return features;
+    }
+}
+
+const Features& detect() {
+    static const Features features = probe();
+    return features;
+}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+
+// What the SIMD kernel families share: target macros, one CPUID probe, and the slot each
+// family keeps its active kernel table in.
+//
+//   HNS_X86         x86 or x86-64; the vector kernels and <immintrin.h> are available
+//   HNS_X86_64      x86-64 only, for kernels built on 64-bit-only instructions (PDEP/PEXT)
+//   HNS_TARGET(isa) compiles one function for `isa` whatever the global target flags
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HNS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HNS_X86_64 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HNS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define HNS_TARGET(isa)
+#endif
+
+namespace CpuFeatures {
+
+    // Extensions the CPU has and the OS saves the register state of. All false off x86.
+    struct Features {
+        bool sse2 = false;
+        bool bmi2 = false;
+        bool avx2 = false;
+        bool avx512bw = false;  // Together with AVX-512F
+    };
+
+    // Probed once, on first use
+    const Features& detect();
+
+    // The kernel table a family dispatches to. Only setIsa-style overrides swap it, and each
+    // table is a constant, so relaxed ordering is enough.
+    template <typename Table>
+    class DispatchSlot {
+    public:
+        explicit DispatchSlot(const Table* initial) : table(initial) {}
+
+        [[nodiscard]] const Table& get() const { return *table.load(std::memory_order_relaxed); }
+        void set(const Table* next) { table.store(next, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<const Table*> table;
+    };
+}
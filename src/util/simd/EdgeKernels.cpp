@@ -0,0 +1,196 @@
+#include "EdgeKernels.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+namespace EdgeKernels {
+
+namespace {
+    struct Dispatch {
+        Isa isa;
+        void (*luma)(const unsigned char* pixels, int channels, unsigned char* luma, size_t count);
+        void (*edgeRow)(const unsigned char* above, const unsigned char* row, const unsigned char* below,
+                        uint32_t minMagnitudeSquared, unsigned char* edges, size_t width);
+    };
+
+    // (0.587 * g + 0.114 * b) / 0.701 in Q15. Checked against the float formula for every
+    // pair of even green and blue values, which are all the kernel ever sees.
+    constexpr int GreenWeight = 27439;
+    constexpr int BlueWeight = 5329;
+    constexpr int WeightShift = 15;
+    constexpr unsigned char SurvivingBits = 0xFE;
+
+    // Scalar kernels, for CPUs without AVX2 and for the columns past the last full vector
+
+    void lumaScalar(const unsigned char* pixels, const int channels, unsigned char* luma, const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* p = pixels + i * channels;
+            luma[i] = static_cast<unsigned char>(
+                (GreenWeight * (p[1] & SurvivingBits) + BlueWeight * (p[2] & SurvivingBits)) >> WeightShift);
+        }
+    }
+
+    // The 3x3 kernel weighs every neighbour equally, so it separates into a column sum for
+    // the horizontal gradient and a row sum for the vertical one
+    void edgeRowScalar(const unsigned char* above, const unsigned char* row, const unsigned char* below,
+                       const uint32_t minMagnitudeSquared, unsigned char* edges, const size_t width) {
+        for (size_t x = 1; x + 1 < width; ++x) {
+            const int gx = (above[x + 1] + row[x + 1] + below[x + 1]) - (above[x - 1] + row[x - 1] + below[x - 1]);
+            const int gy = (below[x - 1] + below[x] + below[x + 1]) - (above[x - 1] + above[x] + above[x + 1]);
+            edges[x] = static_cast<uint32_t>(gx * gx + gy * gy) >= minMagnitudeSquared ? 255 : 0;
+        }
+    }
+
+    constexpr Dispatch ScalarDispatch{ Isa::Scalar, lumaScalar, edgeRowScalar };
+
+#ifdef HNS_X86
+    // ---- AVX2 ----
+
+    // Gathers green and blue of four pixels into 16-bit lanes (g0, b0, g1, b1, ...) so one
+    // multiply-add applies both weights
+    HNS_TARGET("avx2")
+    __m256i greenBlueShuffle(const int channels) {
+        alignas(32) char table[32];
+        for (int lane = 0; lane < 2; ++lane) {
+            for (int k = 0; k < 4; ++k) {
+                char* word = table + lane * 16 + k * 4;
+                word[0] = static_cast<char>(k * channels + 1);
+                word[1] = static_cast<char>(0x80);
+                word[2] = static_cast<char>(k * channels + 2);
+                word[3] = static_cast<char>(0x80);
+            }
+        }
+        return _mm256_load_si256(reinterpret_cast<const __m256i*>(table));
+    }
+
+    HNS_TARGET("avx2")
+    void lumaAvx2(const unsigned char* pixels, const int channels, unsigned char* luma, const size_t count) {
+        if (channels != 3 && channels != 4) {
+            lumaScalar(pixels, channels, luma, count);
+            return;
+        }
+
+        const __m256i shuffle = greenBlueShuffle(channels);
+        const __m256i surviving = _mm256_set1_epi16(SurvivingBits);
+        const __m256i weights = _mm256_set1_epi32(GreenWeight | (BlueWeight << 16));
+
+        // Each 128-bit lane takes four pixels; a lane load reads 16 bytes, which for three
+        // channels runs four bytes past the pixels it uses
+        const size_t laneStride = 4 * static_cast<size_t>(channels);
+        const size_t total = count * channels;
+        size_t i = 0;
+        for (; i + 8 <= count && i * channels + laneStride + 16 <= total; i += 8) {
+            const unsigned char* p = pixels + i * channels;
+            const __m256i bytes = _mm256_loadu2_m128i(reinterpret_cast<const __m128i*>(p + laneStride),
+                                                      reinterpret_cast<const __m128i*>(p));
+            const __m256i words = _mm256_and_si256(_mm256_shuffle_epi8(bytes, shuffle), surviving);
+            const __m256i values = _mm256_srli_epi32(_mm256_madd_epi16(words, weights), WeightShift);
+            const __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(values, values), _mm256_setzero_si256());
+            const __m128i merged = _mm_unpacklo_epi32(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(luma + i), merged);
+        }
+        lumaScalar(pixels + i * channels, channels, luma + i, count - i);
+    }
+
+    HNS_TARGET("avx2")
+    __m256i widen(const unsigned char* p) {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    HNS_TARGET("avx2")
+    void edgeRowAvx2(const unsigned char* above, const unsigned char* row, const unsigned char* below,
+                     const uint32_t minMagnitudeSquared, unsigned char* edges, const size_t width) {
+        // The largest possible magnitude is 2 * 765^2, so larger thresholds all mean "never"
+        const __m256i below32 = _mm256_set1_epi32(
+            static_cast<int>(std::min<uint32_t>(minMagnitudeSquared, INT_MAX)) - 1);
+
+        // Sixteen columns x..x+15 at a time, reading x-1..x+16
+        size_t x = 1;
+        for (; x + 17 <= width; x += 16) {
+            const __m256i aLeft = widen(above + x - 1), aMid = widen(above + x), aRight = widen(above + x + 1);
+            const __m256i bLeft = widen(below + x - 1), bMid = widen(below + x), bRight = widen(below + x + 1);
+
+            const __m256i right = _mm256_add_epi16(_mm256_add_epi16(aRight, bRight), widen(row + x + 1));
+            const __m256i left = _mm256_add_epi16(_mm256_add_epi16(aLeft, bLeft), widen(row + x - 1));
+            const __m256i gx = _mm256_sub_epi16(right, left);
+            const __m256i gy = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(bLeft, bMid), bRight),
+                                                _mm256_add_epi16(_mm256_add_epi16(aLeft, aMid), aRight));
+
+            // Interleaving gx with gy lets one multiply-add square and sum them. The unpacks
+            // split each lane in halves and the packs put them back in column order.
+            const __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+            const __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+            const __m256i edgeLo = _mm256_cmpgt_epi32(_mm256_madd_epi16(lo, lo), below32);
+            const __m256i edgeHi = _mm256_cmpgt_epi32(_mm256_madd_epi16(hi, hi), below32);
+            const __m256i mask16 = _mm256_packs_epi32(edgeLo, edgeHi);
+            const __m256i mask8 = _mm256_permute4x64_epi64(_mm256_packs_epi16(mask16, mask16), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(edges + x), _mm256_castsi256_si128(mask8));
+        }
+        if (x + 1 < width) {
+            // The scalar kernel skips column 0 of whatever it is given, so hand it x-1 on
+            edgeRowScalar(above + x - 1, row + x - 1, below + x - 1, minMagnitudeSquared, edges + x - 1, width - x + 1);
+        }
+    }
+
+    constexpr Dispatch Avx2Dispatch{ Isa::AVX2, lumaAvx2, edgeRowAvx2 };
+#endif
+
+    bool cpuSupports(const Isa isa) {
+        return isa == Isa::Scalar || (isa == Isa::AVX2 && CpuFeatures::detect().avx2);
+    }
+
+    const Dispatch* dispatchFor(const Isa isa) {
+#ifdef HNS_X86
+        if (isa == Isa::AVX2) return &Avx2Dispatch;
+#endif
+        return &ScalarDispatch;
+    }
+
+    CpuFeatures::DispatchSlot<Dispatch>& active() {
+        static CpuFeatures::DispatchSlot<Dispatch> slot{ dispatchFor(detectIsa()) };
+        return slot;
+    }
+}
+
+Isa detectIsa() {
+    return cpuSupports(Isa::AVX2) ? Isa::AVX2 : Isa::Scalar;
+}
+
+Isa activeIsa() {
+    return active().get().isa;
+}
+
+void setIsa(const Isa isa) {
+    active().set(dispatchFor(cpuSupports(isa) ? isa : Isa::Scalar));
+}
+
+std::string isaName(const Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+void luma(const std::span<const unsigned char> pixels, const int channels, const std::span<unsigned char> luma) {
+    if (channels < 3) {
+        throw std::invalid_argument("Luma needs at least 3 channels");
+    }
+    if (pixels.size() / channels < luma.size()) {
+        throw std::invalid_argument("Too few pixels for luma plane");
+    }
+    active().get().luma(pixels.data(), channels, luma.data(), luma.size());
+}
+
+void edgeRow(const std::span<const unsigned char> above, const std::span<const unsigned char> row,
+             const std::span<const unsigned char> below, const uint32_t minMagnitudeSquared,
+             const std::span<unsigned char> edges) {
+    const size_t width = edges.size();
+    if (above.size() < width || row.size() < width || below.size() < width) {
+        throw std::invalid_argument("Edge rows shorter than the edge map");
+    }
+    active().get().edgeRow(above.data(), row.data(), below.data(),
+                                                      minMagnitudeSquared, edges.data(), width);
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Edge-map kernels for PVD steganography. The luma plane is built from green and blue with
+// their low bits cleared, the part of a pixel that survives embedding, in fixed point that
+// matches the original float formula exactly. Each kernel has a scalar fallback plus an
+// AVX2 variant picked at runtime from the CPU's capabilities.
+namespace EdgeKernels {
+
+    enum class Isa { Scalar, AVX2 };
+
+    // Best instruction set supported by this CPU.
+    Isa detectIsa();
+
+    // Instruction set the kernels currently dispatch to.
+    Isa activeIsa();
+
+    // Overrides detectIsa(), falling back to scalar if the CPU lacks `isa`. For benchmarks.
+    void setIsa(Isa isa);
+
+    std::string isaName(Isa isa);
+
+    // Writes the luma of luma.size() pixels, `channels` (at least 3) bytes each.
+    void luma(std::span<const unsigned char> pixels, int channels, std::span<unsigned char> luma);
+
+    // Marks edges[x] 255 where the 3x3 gradient around column x of `row` has a squared
+    // magnitude of at least minMagnitudeSquared, 0 elsewhere. The first and last columns
+    // have no full neighbourhood and are left untouched.
+    void edgeRow(std::span<const unsigned char> above, std::span<const unsigned char> row,
+                 std::span<const unsigned char> below, uint32_t minMagnitudeSquared,
+                 std::span<unsigned char> edges);
+}
@@ -0,0 +1,420 @@
+#include "LSBKernels.h"
+#include "CpuFeatures.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace LSBKernels {
+
+namespace {
+    using EmbedFn = void (*)(unsigned char* carrier, const unsigned char* payload, size_t count);
+    using ExtractFn = void (*)(const unsigned char* carrier, unsigned char* payload, size_t count);
+
+    // Kernels are indexed by bitsPerChannel - 1
+    struct Dispatch {
+        Isa isa;
+        std::array<EmbedFn, 4> embed;
+        std::array<ExtractFn, 4> extract;
+    };
+
+    template<int Bits>
+    constexpr size_t Chunks = carrierBytesPerByte(Bits);
+
+    template<int Bits>
+    constexpr unsigned char BitMask = (1 << Bits) - 1;
+
+    // Portable versions, one bit group at a time; the BMI2 and AVX2 paths hand them their remainders
+
+    template<int Bits>
+    void embedScalar(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        for (size_t j = 0; j < count; ++j) {
+            const unsigned char byte = payload[j];
+            for (size_t i = 0; i < Chunks<Bits>; ++i) {
+                carrier[i] = static_cast<unsigned char>((carrier[i] & ~BitMask<Bits>) | ((byte >> (i * Bits)) & BitMask<Bits>));
+            }
+            carrier += Chunks<Bits>;
+        }
+    }
+
+    template<int Bits>
+    void extractScalar(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        for (size_t j = 0; j < count; ++j) {
+            unsigned int byte = 0;
+            for (size_t i = 0; i < Chunks<Bits>; ++i) {
+                byte |= (carrier[i] & BitMask<Bits>) << (i * Bits);
+            }
+            payload[j] = static_cast<unsigned char>(byte);
+            carrier += Chunks<Bits>;
+        }
+    }
+
+    constexpr Dispatch ScalarDispatch{ Isa::Scalar,
+        { embedScalar<1>, embedScalar<2>, embedScalar<3>, embedScalar<4> },
+        { extractScalar<1>, extractScalar<2>, extractScalar<3>, extractScalar<4> } };
+
+#ifdef HNS_X86_64
+    // ---- BMI2 ----
+    // One PDEP/PEXT moves a whole 64-bit carrier word, i.e. 1, 2 or 4 payload bytes at 1, 2
+    // and 4 bits. At 3 bits a payload byte spans 3 carrier bytes (its ninth bit stays zero),
+    // so each PDEP/PEXT covers two payload bytes in 6 carrier bytes, and four of them are
+    // stitched into three whole words to keep loads and stores aligned to 8 bytes.
+
+    template<int Bits>
+    constexpr uint64_t WordMask = 0x0101010101010101ull * BitMask<Bits>;
+
+    template<int Bits>
+    HNS_TARGET("bmi2")
+    void embedBmi2(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        constexpr size_t PayloadBytes = 8 / Chunks<Bits>;
+        size_t j = 0;
+        for (; j + PayloadBytes <= count; j += PayloadBytes) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, payload + j, PayloadBytes);
+            uint64_t word;
+            std::memcpy(&word, carrier, 8);
+            word = (word & ~WordMask<Bits>) | _pdep_u64(bits, WordMask<Bits>);
+            std::memcpy(carrier, &word, 8);
+            carrier += 8;
+        }
+        embedScalar<Bits>(carrier, payload + j, count - j);
+    }
+
+    template<int Bits>
+    HNS_TARGET("bmi2")
+    void extractBmi2(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        constexpr size_t PayloadBytes = 8 / Chunks<Bits>;
+        size_t j = 0;
+        for (; j + PayloadBytes <= count; j += PayloadBytes) {
+            uint64_t word;
+            std::memcpy(&word, carrier, 8);
+            const uint64_t bits = _pext_u64(word, WordMask<Bits>);
+            std::memcpy(payload + j, &bits, PayloadBytes);
+            carrier += 8;
+        }
+        extractScalar<Bits>(carrier, payload + j, count - j);
+    }
+
+    constexpr uint64_t Bits3PairMask = 0x070707070707ull;
+
+    template<>
+    HNS_TARGET("bmi2")
+    void embedBmi2<3>(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        size_t j = 0;
+        for (; j + 8 <= count; j += 8) {
+            uint64_t pairs[4];
+            for (size_t s = 0; s < 4; ++s) {
+                const uint64_t bits = payload[j + 2 * s] | static_cast<uint64_t>(payload[j + 2 * s + 1]) << 9;
+                pairs[s] = _pdep_u64(bits, Bits3PairMask);
+            }
+            const uint64_t bits[3] = {
+                pairs[0] | pairs[1] << 48, pairs[1] >> 16 | pairs[2] << 32, pairs[2] >> 32 | pairs[3] << 16
+            };
+            uint64_t words[3];
+            std::memcpy(words, carrier, 24);
+            for (size_t w = 0; w < 3; ++w) words[w] = (words[w] & ~WordMask<3>) | bits[w];
+            std::memcpy(carrier, words, 24);
+            carrier += 24;
+        }
+        embedScalar<3>(carrier, payload + j, count - j);
+    }
+
+    template<>
+    HNS_TARGET("bmi2")
+    void extractBmi2<3>(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        size_t j = 0;
+        for (; j + 8 <= count; j += 8) {
+            uint64_t words[3];
+            std::memcpy(words, carrier, 24);
+            const uint64_t pairs[4] = {
+                words[0], words[0] >> 48 | words[1] << 16, words[1] >> 32 | words[2] << 32, words[2] >> 16
+            };
+            for (size_t s = 0; s < 4; ++s) {
+                const uint64_t bits = _pext_u64(pairs[s], Bits3PairMask);
+                payload[j + 2 * s] = static_cast<unsigned char>(bits);
+                payload[j + 2 * s + 1] = static_cast<unsigned char>(bits >> 9);
+            }
+            carrier += 24;
+        }
+        extractScalar<3>(carrier, payload + j, count - j);
+    }
+
+    // ---- AVX2 ----
+    // Embedding spreads the payload to one chunk per byte lane and merges it into the
+    // carrier with a single and/or; extraction masks the lanes and folds neighbouring
+    // chunks back together with multiply-adds. Preferred over BMI2 because PDEP/PEXT are
+    // microcoded, and very slow, on AMD CPUs before Zen 3.
+
+    HNS_TARGET("avx2")
+    inline void mergeLowBits(unsigned char* carrier, const __m256i bits, const __m256i keep) {
+        auto* lanes = reinterpret_cast<__m256i*>(carrier);
+        _mm256_storeu_si256(lanes, _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256(lanes), keep), bits));
+    }
+
+    // Splits every byte of v into its low and high Shift bits, interleaved: [b0 & m, b0 >> Shift, b1 & m, ...]
+    template<int Shift>
+    HNS_TARGET("avx2")
+    inline __m256i splitBytes(const __m128i v) {
+        const __m128i mask = _mm_set1_epi8(static_cast<char>((1 << Shift) - 1));
+        const __m128i low = _mm_and_si128(v, mask);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(v, Shift), mask);
+        return _mm256_set_m128i(_mm_unpackhi_epi8(low, high), _mm_unpacklo_epi8(low, high));
+    }
+
+    HNS_TARGET("avx2")
+    void embedAvx2Bits1(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        // Every lane picks its payload byte, then tests its own bit of it
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i select = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+        const __m256i one = _mm256_set1_epi8(1);
+        const __m256i keep = _mm256_set1_epi8(static_cast<char>(0xFE));
+
+        size_t j = 0;
+        for (; j + 4 <= count; j += 4) {
+            int32_t word;
+            std::memcpy(&word, payload + j, 4);
+            const __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(word), spread);
+            mergeLowBits(carrier, _mm256_min_epu8(_mm256_and_si256(bytes, select), one), keep);
+            carrier += 32;
+        }
+        embedScalar<1>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void extractAvx2Bits1(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        size_t j = 0;
+        for (; j + 4 <= count; j += 4) {
+            // Shift bit 0 of every lane into its sign bit, which movemask packs into one bit per lane
+            const __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(carrier));
+            const auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(lanes, 7)));
+            std::memcpy(payload + j, &bits, 4);
+            carrier += 32;
+        }
+        extractScalar<1>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void embedAvx2Bits2(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        const __m256i keep = _mm256_set1_epi8(static_cast<char>(0xFC));
+
+        size_t j = 0;
+        for (; j + 8 <= count; j += 8) {
+            // Bytes to nibbles to 2-bit chunks
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(payload + j));
+            const __m128i nibbles = _mm256_castsi256_si128(splitBytes<4>(bytes));
+            mergeLowBits(carrier, splitBytes<2>(nibbles), keep);
+            carrier += 32;
+        }
+        embedScalar<2>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void extractAvx2Bits2(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        const __m256i mask = _mm256_set1_epi8(3);
+        const __m256i chunkPairs = _mm256_set1_epi16(0x0401);       // c0 + 4 * c1
+        const __m256i nibblePairs = _mm256_set1_epi32(0x00100001);  // n0 + 16 * n1
+        const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i order = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+
+        size_t j = 0;
+        for (; j + 8 <= count; j += 8) {
+            const __m256i lanes = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(carrier)), mask);
+            const __m256i nibbles = _mm256_maddubs_epi16(lanes, chunkPairs);
+            const __m256i bytes = _mm256_shuffle_epi8(_mm256_madd_epi16(nibbles, nibblePairs), gather);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(payload + j),
+                             _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(bytes, order)));
+            carrier += 32;
+        }
+        extractScalar<2>(carrier, payload + j, count - j);
+    }
+
+    // At 3 bits, lane k of a 32-byte carrier block holds chunk k % 3 of payload byte k / 3.
+    // Ten payload bytes fill lanes 0-29; lanes 30 and 31 are left untouched.
+    struct Bits3Tables {
+        signed char chunk[3][32];
+        unsigned char keep[32];
+    };
+
+    constexpr Bits3Tables makeBits3Tables() {
+        Bits3Tables tables{};
+        for (int lane = 0; lane < 32; ++lane) {
+            for (int chunk = 0; chunk < 3; ++chunk) {
+                tables.chunk[chunk][lane] = static_cast<signed char>(lane < 30 && lane % 3 == chunk ? lane / 3 : -128);
+            }
+            tables.keep[lane] = lane < 30 ? 0xF8 : 0xFF;
+        }
+        return tables;
+    }
+
+    constexpr Bits3Tables Bits3 = makeBits3Tables();
+
+    HNS_TARGET("avx2")
+    void embedAvx2Bits3(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        const __m256i low3 = _mm256_set1_epi8(7);
+        const __m256i low2 = _mm256_set1_epi8(3);
+        const __m256i chunk0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bits3.chunk[0]));
+        const __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bits3.chunk[1]));
+        const __m256i chunk2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bits3.chunk[2]));
+        const __m256i keep = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bits3.keep));
+
+        // Reads 16 payload bytes per step even though only 10 are consumed
+        size_t j = 0;
+        for (; j + 16 <= count; j += 10) {
+            const __m256i bytes = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(payload + j)));
+            const __m256i bits0 = _mm256_shuffle_epi8(_mm256_and_si256(bytes, low3), chunk0);
+            const __m256i bits1 = _mm256_shuffle_epi8(_mm256_and_si256(_mm256_srli_epi16(bytes, 3), low3), chunk1);
+            const __m256i bits2 = _mm256_shuffle_epi8(_mm256_and_si256(_mm256_srli_epi16(bytes, 6), low2), chunk2);
+            mergeLowBits(carrier, _mm256_or_si256(_mm256_or_si256(bits0, bits1), bits2), keep);
+            carrier += 30;
+        }
+        embedScalar<3>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void extractAvx2Bits3(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        // Each 128-bit lane gathers the chunks of five payload bytes from 15 carrier bytes
+        const __m256i mask = _mm256_set1_epi8(7);
+        const __m256i gather0 = _mm256_setr_epi8(0, 3, 6, 9, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 0, 3, 6, 9, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i gather1 = _mm256_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i gather2 = _mm256_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        // The third chunk only carries the top two bits of the byte
+        const __m256i high2 = _mm256_set1_epi8(3);
+
+        // Reads 31 carrier bytes per step
+        size_t j = 0;
+        for (; j + 11 <= count; j += 10) {
+            const __m256i lanes = _mm256_and_si256(
+                _mm256_set_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(carrier + 15)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(carrier))), mask);
+            const __m256i low = _mm256_shuffle_epi8(lanes, gather0);
+            const __m256i mid = _mm256_slli_epi16(_mm256_shuffle_epi8(lanes, gather1), 3);
+            const __m256i top = _mm256_slli_epi16(_mm256_and_si256(_mm256_shuffle_epi8(lanes, gather2), high2), 6);
+            const __m256i bytes = _mm256_or_si256(_mm256_or_si256(low, mid), top);
+
+            const __m128i joined = _mm_or_si128(_mm256_castsi256_si128(bytes),
+                                                _mm_bslli_si128(_mm256_extracti128_si256(bytes, 1), 5));
+            alignas(16) unsigned char block[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(block), joined);
+            std::memcpy(payload + j, block, 10);
+            carrier += 30;
+        }
+        extractScalar<3>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void embedAvx2Bits4(unsigned char* carrier, const unsigned char* payload, const size_t count) {
+        const __m256i keep = _mm256_set1_epi8(static_cast<char>(0xF0));
+
+        size_t j = 0;
+        for (; j + 16 <= count; j += 16) {
+            mergeLowBits(carrier, splitBytes<4>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(payload + j))), keep);
+            carrier += 32;
+        }
+        embedScalar<4>(carrier, payload + j, count - j);
+    }
+
+    HNS_TARGET("avx2")
+    void extractAvx2Bits4(const unsigned char* carrier, unsigned char* payload, const size_t count) {
+        const __m256i mask = _mm256_set1_epi8(0x0F);
+        const __m256i nibblePairs = _mm256_set1_epi16(0x1001);  // n0 + 16 * n1
+
+        size_t j = 0;
+        for (; j + 16 <= count; j += 16) {
+            const __m256i lanes = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(carrier)), mask);
+            const __m256i words = _mm256_maddubs_epi16(lanes, nibblePairs);
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(payload + j), _mm256_castsi256_si128(packed));
+            carrier += 32;
+        }
+        extractScalar<4>(carrier, payload + j, count - j);
+    }
+
+    constexpr Dispatch Bmi2Dispatch{ Isa::BMI2,
+        { embedBmi2<1>, embedBmi2<2>, embedBmi2<3>, embedBmi2<4> },
+        { extractBmi2<1>, extractBmi2<2>, extractBmi2<3>, extractBmi2<4> } };
+    constexpr Dispatch Avx2Dispatch{ Isa::AVX2,
+        { embedAvx2Bits1, embedAvx2Bits2, embedAvx2Bits3, embedAvx2Bits4 },
+        { extractAvx2Bits1, extractAvx2Bits2, extractAvx2Bits3, extractAvx2Bits4 } };
+#endif
+
+    bool cpuSupports(const Isa isa) {
+        const CpuFeatures::Features& cpu = CpuFeatures::detect();
+        switch (isa) {
+            case Isa::Scalar: return true;
+            case Isa::BMI2:   return cpu.bmi2;
+            case Isa::AVX2:   return cpu.avx2;
+        }
+        return false;
+    }
+
+    const Dispatch* dispatchFor(const Isa isa) {
+#ifdef HNS_X86_64
+        switch (isa) {
+            case Isa::AVX2:   return &Avx2Dispatch;
+            case Isa::BMI2:   return &Bmi2Dispatch;
+            case Isa::Scalar: break;
+        }
+#endif
+        return &ScalarDispatch;
+    }
+
+    CpuFeatures::DispatchSlot<Dispatch>& active() {
+        static CpuFeatures::DispatchSlot<Dispatch> slot{ dispatchFor(detectIsa()) };
+        return slot;
+    }
+
+    void checkBitsPerChannel(const int bitsPerChannel) {
+        if (bitsPerChannel < 1 || bitsPerChannel > 4) {
+            throw std::invalid_argument("Bits per channel must be between 1 and 4");
+        }
+    }
+}
+
+Isa detectIsa() {
+    for (const Isa isa : { Isa::AVX2, Isa::BMI2 }) {
+        if (cpuSupports(isa)) return isa;
+    }
+    return Isa::Scalar;
+}
+
+Isa activeIsa() {
+    return active().get().isa;
+}
+
+void setIsa(Isa isa) {
+    while (isa != Isa::Scalar && !cpuSupports(isa)) {
+        isa = static_cast<Isa>(static_cast<int>(isa) - 1);
+    }
+    active().set(dispatchFor(isa));
+}
+
+std::string isaName(const Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::BMI2:   return "bmi2";
+        case Isa::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+void embed(const std::span<unsigned char> carrier, const std::span<const unsigned char> payload, const int bitsPerChannel) {
+    checkBitsPerChannel(bitsPerChannel);
+    if (payload.size() > carrier.size() / carrierBytesPerByte(bitsPerChannel)) {
+        throw std::invalid_argument("Carrier too small for payload");
+    }
+    active().get().embed[bitsPerChannel - 1](carrier.data(), payload.data(), payload.size());
+}
+
+void extract(const std::span<const unsigned char> carrier, const std::span<unsigned char> payload, const int bitsPerChannel) {
+    checkBitsPerChannel(bitsPerChannel);
+    if (payload.size() > carrier.size() / carrierBytesPerByte(bitsPerChannel)) {
+        throw std::invalid_argument("Carrier too small for payload");
+    }
+    active().get().extract[bitsPerChannel - 1](carrier.data(), payload.data(), payload.size());
+}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Bit-plane kernels for LSB steganography. A payload byte is split LSB-first into
+// chunks of bitsPerChannel bits, one chunk per carrier byte, so it occupies
+// carrierBytesPerByte(bitsPerChannel) carrier bytes. Every depth from 1 to 4 bits has a
+// scalar fallback plus BMI2 (PDEP/PEXT) and AVX2 (shuffle-based) variants picked at
+// runtime from the CPU's capabilities.
+namespace LSBKernels {
+
+    enum class Isa { Scalar, BMI2, AVX2 };
+
+    // Best instruction set supported by this CPU.
+    Isa detectIsa();
+
+    // Instruction set the kernels currently dispatch to.
+    Isa activeIsa();
+
+    // Forces `isa` so benchmarks can compare variants; one the CPU lacks steps down to the next it has.
+    void setIsa(Isa isa);
+
+    std::string isaName(Isa isa);
+
+    constexpr size_t carrierBytesPerByte(const int bitsPerChannel) {
+        return (8 + bitsPerChannel - 1) / bitsPerChannel;
+    }
+
+    // Replaces the low bitsPerChannel bits of the first payload.size() * carrierBytesPerByte()
+    // carrier bytes with the payload. The upper carrier bits are left untouched.
+    void embed(std::span<unsigned char> carrier, std::span<const unsigned char> payload, int bitsPerChannel);
+
+    // Reassembles payload.size() bytes from the low bits of the carrier.
+    void extract(std::span<const unsigned char> carrier, std::span<unsigned char> payload, int bitsPerChannel);
+}
@@ -0,0 +1,146 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+struct ThreadPool::Job {
+    const RangeFunction* fn = nullptr;
+    size_t total = 0;
+    size_t grain = 1;
+    size_t chunks = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> finished{0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() {
+    setThreadCount(0);
+}
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+void ThreadPool::setThreadCount(size_t count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (count == threadCount()) return;
+
+    stopWorkers();
+    startWorkers(count - 1);
+}
+
+size_t ThreadPool::threadCount() const {
+    std::lock_guard lock(mutex);
+    return workers.size() + 1;
+}
+
+void ThreadPool::startWorkers(const size_t count) {
+    std::lock_guard lock(mutex);
+    stopping = false;
+    for (size_t i = 0; i < count; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    std::vector<std::thread> finishing;
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        finishing.swap(workers);
+    }
+    wakeWorkers.notify_all();
+    for (auto& worker : finishing) {
+        worker.join();
+    }
+}
+
+bool ThreadPool::runNextChunk(Job& job) {
+    const size_t chunk = job.next.fetch_add(1);
+    if (chunk >= job.chunks) return false;
+
+    const size_t begin = chunk * job.grain;
+    const size_t end = std::min(job.total, begin + job.grain);
+    try {
+        (*job.fn)(begin, end);
+    } catch (...) {
+        std::lock_guard lock(job.mutex);
+        if (!job.error) job.error = std::current_exception();
+    }
+
+    if (job.finished.fetch_add(1) + 1 == job.chunks) {
+        std::lock_guard lock(job.mutex);
+        job.done.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock lock(mutex);
+            wakeWorkers.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+
+            job = jobs.front();
+            if (job->next.load() >= job->chunks) {
+                jobs.pop_front();
+                continue;
+            }
+        }
+
+        while (runNextChunk(*job)) {}
+    }
+}
+
+void ThreadPool::parallelFor(const size_t total, size_t grain, const RangeFunction& fn) {
+    if (total == 0) return;
+    grain = std::max<size_t>(1, grain);
+
+    const auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->total = total;
+    job->grain = grain;
+    job->chunks = (total + grain - 1) / grain;
+
+    bool queued = false;
+    if (job->chunks > 1) {
+        std::lock_guard lock(mutex);
+        if (!workers.empty()) {
+            jobs.push_back(job);
+            queued = true;
+        }
+    }
+    if (queued) {
+        wakeWorkers.notify_all();
+    }
+
+    while (runNextChunk(*job)) {}
+
+    {
+        std::unique_lock lock(job->mutex);
+        job->done.wait(lock, [&] { return job->finished.load() == job->chunks; });
+    }
+
+    if (queued) {
+        std::lock_guard lock(mutex);
+        if (const auto it = std::ranges::find(jobs, job); it != jobs.end()) {
+            jobs.erase(it);
+        }
+    }
+
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Process-wide pool of worker threads. The calling thread always takes part in its
+// own parallelFor, so nested calls from inside a worker cannot deadlock.
+class ThreadPool {
+public:
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    static ThreadPool& instance();
+
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total threads used by parallelFor, including the caller. 0 means one per hardware thread.
+    void setThreadCount(size_t count);
+    [[nodiscard]] size_t threadCount() const;
+
+    // Splits [0, total) into chunks of `grain` elements and runs fn(begin, end) on each,
+    // spread across the pool. Blocks until every chunk is done and rethrows the first
+    // exception thrown by fn.
+    void parallelFor(size_t total, size_t grain, const RangeFunction& fn);
+
+private:
+    struct Job;
+
+    ThreadPool();
+
+    void startWorkers(size_t count);
+    void stopWorkers();
+    void workerLoop();
+    static bool runNextChunk(Job& job);
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
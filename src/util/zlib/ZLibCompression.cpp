@@ -1,15 +1,52 @@
 #include "ZLibCompression.h"
 #include <zlib.h>
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
 
-std::vector<unsigned char> ZLIBCompression::compressData(const std::vector<unsigned char>& data) {
-    uLongf compressedSize = compressBound(data.size());
-    std::vector<unsigned char> compressedData(compressedSize);
-
-    if (compress(compressedData.data(), &compressedSize, data.data(), data.size()) != Z_OK) {
+ZLIBCompression::Deflater::Deflater(const std::span<const unsigned char> input)
+    : stream(std::make_unique<z_stream_s>()), input(input), bound(compressBound(input.size())) {
+    if (deflateInit(stream.get(), Z_DEFAULT_COMPRESSION) != Z_OK) {
         throw std::runtime_error("Compression failed");
     }
+}
+
+ZLIBCompression::Deflater::~Deflater() {
+    deflateEnd(stream.get());
+}
+
+size_t ZLIBCompression::Deflater::read(const std::span<unsigned char> out) {
+    size_t written = 0;
+    while (!finished && written < out.size()) {
+        // avail_in and avail_out are 32-bit, so very large inputs are fed in slices
+        const size_t slice = std::min<size_t>(input.size(), UINT_MAX);
+        stream->next_in = const_cast<unsigned char*>(input.data());
+        stream->avail_in = static_cast<uInt>(slice);
+        stream->next_out = out.data() + written;
+        stream->avail_out = static_cast<uInt>(std::min<size_t>(out.size() - written, UINT_MAX));
+
+        const int status = deflate(stream.get(), slice == input.size() ? Z_FINISH : Z_NO_FLUSH);
+        if (status == Z_STREAM_ERROR) {
+            throw std::runtime_error("Compression failed");
+        }
+
+        input = input.subspan(slice - stream->avail_in);
+        written = stream->next_out - out.data();
+        finished = status == Z_STREAM_END;
+    }
+    return written;
+}
+
+std::vector<unsigned char> ZLIBCompression::compressData(const std::vector<unsigned char>& data) {
+    // Grows with the output instead of reserving compressBound() up front
+    Deflater deflater(data);
+    std::vector<unsigned char> compressedData;
+    size_t used = 0;
+    do {
+        compressedData.resize(std::max<size_t>(used + 64 * 1024, compressedData.size() * 3 / 2));
+    } while ((used += deflater.read(std::span(compressedData).subspan(used))) == compressedData.size());
 
-    compressedData.resize(compressedSize);
+    compressedData.resize(used);
     return compressedData;
 }
 
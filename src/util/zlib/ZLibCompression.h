@@ -1,10 +1,37 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <vector>
 #include <zconf.h>
 
+struct z_stream_s;
+
 class ZLIBCompression {
 public:
+    // Compresses a buffer into a zlib stream a piece at a time, so callers can pass the
+    // output on in fixed-size chunks instead of holding all of it.
+    class Deflater {
+    public:
+        explicit Deflater(std::span<const unsigned char> input);
+        ~Deflater();
+
+        Deflater(const Deflater&) = delete;
+        Deflater& operator=(const Deflater&) = delete;
+
+        // Upper bound on the total output, from compressBound()
+        [[nodiscard]] size_t maxOutputSize() const { return bound; }
+
+        // Fills as much of `out` as possible; returns the bytes written, 0 once the stream is complete
+        size_t read(std::span<unsigned char> out);
+
+    private:
+        std::unique_ptr<z_stream_s> stream;
+        std::span<const unsigned char> input;
+        size_t bound;
+        bool finished = false;
+    };
+
     static std::vector<unsigned char> compressData(const std::vector<unsigned char>& data);
     static std::vector<unsigned char> decompressData(const std::vector<unsigned char>& data, uLongf originalSize);
 };